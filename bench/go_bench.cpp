@@ -0,0 +1,192 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "../go/go.h"
+
+// Micro-benchmarks for the Board and Bot hot paths.
+//
+// Usage: go_bench [filter] [min seconds per benchmark]
+// Only benchmarks whose name contains the filter are run.
+
+static std::string filter;
+static double min_seconds = 0.5;
+static long sink; // Keeps results alive so the work is not optimised away
+
+// Runs `op` until at least min_seconds have passed and prints how many `unit`s per second it managed.
+// `op` returns how many units of work it did.
+static void bench(const std::string& name, const std::string& unit, const std::function<long()>& op) {
+    if (name.find(filter) == std::string::npos) return;
+
+    using clock = std::chrono::steady_clock;
+    long units = 0, calls = 0;
+    auto start = clock::now();
+    double elapsed;
+    do {
+        units += op();
+        calls++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < min_seconds);
+
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(14) << std::fixed << std::setprecision(2)
+              << units / elapsed << " " << std::left << std::setw(12) << unit + "/s" << std::right
+              << std::setw(14) << elapsed * 1e6 / (double) calls << " us/call" << std::endl;
+}
+
+// A quiet middle-game position: random legal moves that leave nobody in atari
+static Board make_position(int stones) {
+    Board board;
+    Color turn = BLACK;
+    for (int placed = 0, tries = 0; placed < stones && tries < 10000; tries++) {
+        Pos p{std::rand() % size, std::rand() % size};
+        Board next = board.copy();
+        if (!next.place_stone(turn, p) || Bot::isInAtari(next, BLACK) || Bot::isInAtari(next, WHITE)) continue;
+        board = next.copy();
+        turn = ~turn;
+        placed++;
+    }
+    return board;
+}
+
+// White stone with two liberties that black can chase down a ladder to the edge
+static Board make_ladder() {
+    Board board;
+    board.place_stone(WHITE, {4, 4});
+    board.place_stone(BLACK, {3, 4});
+    board.place_stone(BLACK, {4, 3});
+    board.place_stone(BLACK, {5, 5});
+    return board;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) filter = argv[1];
+    if (argc > 2) min_seconds = std::stod(argv[2]);
+    std::srand(1);
+
+    const Board position = make_position(30), opening = make_position(6);
+    std::vector<Pos> game;
+    {
+        Board board;
+        Color turn = BLACK;
+        for (int i = 0; i < 1000 && game.size() < 60; i++) {
+            Pos p{std::rand() % size, std::rand() % size};
+            if (board.place_stone(turn, p)) game.push_back(p), turn = ~turn;
+        }
+    }
+
+    bench("place_stone", "moves", [&] {
+        Board board;
+        Color turn = BLACK;
+        for (Pos p : game) board.place_stone(turn, p), turn = ~turn;
+        return (long) game.size();
+    });
+
+    bench("Board::copy", "copies", [&] {
+        sink += (long) position.copy().activeGroups.size();
+        return 1L;
+    });
+
+    bench("is_point_an_eye", "points", [&] {
+        for (int row = 0; row < size; row++) for (int col = 0; col < size; col++)
+            sink += Bot::is_point_an_eye(position, {row, col}, BLACK);
+        return (long) (size * size);
+    });
+
+    {
+        Board board = position.copy();
+        Bot::Settings settings = Bot::level_settings(Bot::HARD);
+        Bot plain(settings, BLACK, board);
+        settings.minimax_shapes = true;
+        Bot shapes(settings, BLACK, board);
+        bench("minimax_eval", "leaves", [&] {
+            sink += plain.minimax_eval(position, BLACK);
+            return 1L;
+        });
+        bench("minimax_eval/shapes", "leaves", [&] {
+            sink += shapes.minimax_eval(position, BLACK);
+            return 1L;
+        });
+    }
+
+    {
+        Board board = position.copy();
+        Bot bot(Bot::MEDIUM, BLACK, board);
+        MoveList candidates;
+        Bot::find_candidate_moves(position, BLACK, candidates);
+        int i = 0;
+        bench("play_random_game", "playouts", [&] {
+            sink += bot.play_random_game(position, BLACK, candidates[i++ % candidates.size()].pos()).has_value();
+            return 1L;
+        });
+    }
+
+    {
+        Board board = make_ladder();
+        Bot bot(Bot::CRAZY, BLACK, board);
+        bench("find_forced_capture", "reads", [&] {
+            Move m;
+            sink += bot.find_forced_capture(board, BLACK, m);
+            return 1L;
+        });
+    }
+
+    // Threads recording playouts as get_move does: one add for the candidate, its own point here, and several to
+    // random points for the all-moves-as-first statistics. Updates per second should grow with the threads, up to
+    // the number of cores.
+    for (int threads : {1, 2, 4, 8, 16, 32}) {
+        MoveStats stats;
+        bench("MoveStats/" + std::to_string(threads) + " threads", "updates", [&] {
+            constexpr int playouts = 1 << 14, amaf_points = 7;
+            // Fresh counts each time, as a search would have, so that repeated calls cannot overflow them
+            stats.clear();
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; t++) workers.emplace_back([&stats, t] {
+                uint64_t seed = t;
+                for (int i = 0; i < playouts; i++) {
+                    uint64_t r = splitmix64(seed);
+                    stats.add(t % (size * size), r & 1, r & 2);
+                    for (int j = 0; j < amaf_points; j++)
+                        stats.add((int) ((r >> (8 * j + 8)) % (size * size)), r & 1, r & 2);
+                }
+            });
+            for (auto& w : workers) w.join();
+            sink += stats.get(0).visits;
+            return (long) threads * playouts * (1 + amaf_points);
+        });
+    }
+
+    {
+        // Positions late enough for the endgame solver, analysed as a batch and then with a fresh bot for each, as
+        // single get_move calls would
+        std::vector<Board> positions;
+        for (int i = 0; i < 16; i++) positions.push_back(make_position(size * size - 14));
+        Board board;
+        Bot bot(Bot::CRAZY, BLACK, board);
+        bench("get_moves/CRAZY", "positions", [&] {
+            for (auto [m, score] : bot.get_moves(positions)) sink += m.point();
+            return (long) positions.size();
+        });
+        bench("get_move/CRAZY each", "positions", [&] {
+            for (const Board& p : positions) {
+                Board copy = p.copy();
+                sink += Bot(Bot::CRAZY, BLACK, copy).get_move().point();
+            }
+            return (long) positions.size();
+        });
+    }
+
+    const char* levels[] = {"JOKE", "EASY", "MEDIUM", "HARD", "CRAZY", "DEMON"};
+    for (int level = Bot::JOKE; level <= Bot::DEMON; level++) {
+        // Early on there are no tactics to shortcut the search
+        Board board = opening.copy();
+        Bot bot((Bot::BotLevel) level, BLACK, board);
+        bench(std::string("get_move/") + levels[level], "moves", [&] {
+            sink += bot.get_move().point();
+            return 1L;
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <charconv>
+#include <stdexcept>
+#include <random>
+#include "../go/go.h"
+
+// Counts every legal move sequence up to a given depth, as a correctness oracle for Board and a measure of raw
+// move generation speed. Any change to Board must leave these numbers the same.
+//
+// Usage: go_perft <depth> [board] [b|w] [-d] [-a]
+//        go_perft -c <games>
+//   board  the position in Board::to_string() format, rows optionally separated by '/' (empty board by default)
+//   b|w    the side to move (black by default)
+//   -d     also print the nodes below each first move at the last depth
+//   -a     atari go: stop at the first capture instead of playing on
+//   -c     self-check instead, on every position of that many random games: Board's incrementally kept state
+//          against a recount, and Bot::is_net against an exhaustive search. Exits with 1 on any mismatch.
+
+struct PerftCounts {
+    long nodes = 0, captures = 0, suicides = 0;
+
+    void operator+=(const PerftCounts& other) {
+        nodes += other.nodes;
+        captures += other.captures;
+        suicides += other.suicides;
+    }
+};
+
+// Counts are of the moves at the last ply only
+static void perft(const Board& board, Color turn, int depth, bool atari, PerftCounts& counts) {
+    for (int row = 0; row < size; row++) for (int col = 0; col < size; col++) {
+        Pos p{row, col};
+        if (board[p]) continue;
+
+        bool suicide = board.is_suicide(turn, p), capture = board.is_capture(turn, p);
+        Board next = board.copy();
+        if (next.place_stone(turn, p) == suicide)
+            throw std::logic_error("place_stone and is_suicide disagree at " + std::to_string(row) + "," + std::to_string(col));
+        if (suicide) {
+            if (depth == 1) counts.suicides++;
+            continue;
+        }
+        if (depth == 1) {
+            counts.nodes++;
+            counts.captures += capture;
+        }
+        else if (!(capture && atari)) perft(next, ~turn, depth - 1, atari, counts);
+    }
+}
+
+// What a board keeps up to date as stones come and go, checked against the same worked out from scratch
+static bool board_consistent(const Board& board) {
+    std::array<uint64_t, 8> hashes{};
+    std::array<std::array<uint8_t, size * size>, 2> liberty_counts{};
+    std::array<std::array<uint8_t, Board::NUM_SHAPES>, 2> shape_counts{};
+    for (int i = 0; i < size * size; i++) {
+        Pos p{i / size, i % size};
+        if (board[p]) {
+            for (int s = 0; s < 8; s++) hashes[s] ^= zobrist_keys[board[p]->color][point_symmetries[s][i]];
+        }
+        else for (Color color : {BLACK, WHITE}) {
+            if (auto shape = Board::shape_of(board.locality_code(p, BLACK), color)) shape_counts[color][*shape]++;
+        }
+    }
+    for (const Group& g : board.activeGroups) liberty_counts[g->color][g->numLiberties()]++;
+
+    // The same stones placed afresh, in board order with nothing captured, must give the same neighbourhoods
+    Board fresh = Board::from_string(board.to_string());
+    return hashes == board.hashes && liberty_counts == board.liberty_counts && shape_counts == board.shape_counts &&
+           fresh.locality_codes == board.locality_codes && fresh.locality2_hashes == board.locality2_hashes;
+}
+
+// Whether `attacker`, to move, can capture now or play a move after which every reply still leaves a capture
+static bool surely_captures(const Board& board, Color attacker) {
+    Color defender = ~attacker;
+    for (int i = 0; i < size * size; i++) {
+        Pos a{i / size, i % size};
+        if (!board.is_valid_move(attacker, a)) continue;
+        if (board.is_capture(attacker, a)) return true;
+        Board after = board.copy();
+        after.place_stone(attacker, a);
+        // The defender would capture first, or could pass
+        if (Bot::isInAtari(after, attacker) || !Bot::isInAtari(after, defender)) continue;
+        bool holds = true;
+        for (int j = 0; j < size * size && holds; j++) {
+            Pos d{j / size, j % size};
+            if (!after.is_valid_move(defender, d)) continue;
+            if (after.is_capture(defender, d)) holds = false;
+            else {
+                Board reply = after.copy();
+                reply.place_stone(defender, d);
+                holds = Bot::isInAtari(reply, defender);
+            }
+        }
+        if (holds) return true;
+    }
+    return false;
+}
+
+// Plays random games, captures and all, checking every position on the way
+static int self_check(int games) {
+    std::mt19937 rng(1);
+    long positions = 0, groups = 0, nets = 0, false_nets = 0, inconsistent = 0;
+    for (int game = 0; game < games; game++) {
+        Board board;
+        Color turn = BLACK;
+        for (int ply = 0; ply < 2 * size * size; ply++, turn = ~turn) {
+            positions++;
+            if (!board_consistent(board)) inconsistent++;
+            for (const Group& g : board.activeGroups) if (g->color != turn && g->numLiberties() == 2) {
+                groups++;
+                if (!Bot::is_net(board, *g->stones.begin(), turn)) continue;
+                nets++;
+                if (!surely_captures(board, turn)) false_nets++;
+            }
+
+            MoveList moves;
+            for (int i = 0; i < size * size; i++) {
+                Pos p{i / size, i % size};
+                if (board.is_valid_move(turn, p)) moves.push_back(Move::play_at(turn, p));
+            }
+            if (moves.empty()) break;
+            board.place_stone(turn, moves[(int) (rng() % moves.size())].pos());
+        }
+    }
+    std::cout << positions << " positions  " << inconsistent << " inconsistent boards  " << groups
+              << " groups with two liberties  " << nets << " nets  " << false_nets << " false nets" << std::endl;
+    return inconsistent || false_nets ? 1 : 0;
+}
+
+static int usage() {
+    std::cerr << "Usage: go_perft <depth> [board] [b|w] [-d] [-a]\n"
+                 "       go_perft -c <games>" << std::endl;
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    int depth = 0;
+    bool divide = false, atari = false;
+    Board board;
+    Color turn = BLACK;
+    if (argc == 3 && !std::strcmp(argv[1], "-c")) {
+        int games = 0;
+        auto [end, error] = std::from_chars(argv[2], argv[2] + std::strlen(argv[2]), games);
+        if (error != std::errc() || *end || games <= 0) return usage();
+        return self_check(games);
+    }
+    try {
+        for (int i = 1; i < argc; i++) {
+            if (!std::strcmp(argv[i], "-d")) divide = true;
+            else if (!std::strcmp(argv[i], "-a")) atari = true;
+            else if (!std::strcmp(argv[i], "b") || !std::strcmp(argv[i], "w")) turn = argv[i][0] == 'b' ? BLACK : WHITE;
+            else if (!depth) {
+                auto [end, error] = std::from_chars(argv[i], argv[i] + std::strlen(argv[i]), depth);
+                if (error != std::errc() || *end) return usage();
+            }
+            else board = Board::from_string(argv[i]);
+        }
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return usage();
+    }
+    if (depth <= 0) return usage();
+
+    std::cout << board.to_string() << (turn == BLACK ? "Black" : "White") << " to move" << std::endl;
+
+    for (int d = 1; d <= depth; d++) {
+        auto start = std::chrono::steady_clock::now();
+        PerftCounts counts;
+        if (divide && d == depth && d > 1) {
+            for (int row = 0; row < size; row++) for (int col = 0; col < size; col++) {
+                Board next = board.copy();
+                if ((atari && board.is_capture(turn, {row, col})) || !next.place_stone(turn, {row, col})) continue;
+                PerftCounts sub;
+                perft(next, ~turn, d - 1, atari, sub);
+                std::cout << "  " << row << "," << col << ": " << sub.nodes << std::endl;
+                counts += sub;
+            }
+        }
+        else perft(board, turn, d, atari, counts);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "depth " << d << "  nodes " << counts.nodes << "  captures " << counts.captures
+                  << "  suicides " << counts.suicides << "  " << std::fixed << std::setprecision(3) << seconds << " s  "
+                  << std::setprecision(0) << counts.nodes / seconds << " nodes/s" << std::endl;
+    }
+    return 0;
+}
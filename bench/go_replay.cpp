@@ -0,0 +1,124 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "../go/go.h"
+#include "../go/sgf.h"
+#include "../go/game_db.h"
+#include "../go/mapped_file.h"
+
+// Replays recorded games through Board::place_stone, and optionally asks a bot for a move at every position, to
+// measure the engine on real games rather than synthetic positions.
+//
+// Usage: go_replay <file>... [-l level] [-n games]
+//   file      an SGF collection, or a game database written by go_db
+//   -l level  also time get_move for the side to move at every position, level being 1 to 6 for JOKE to DEMON
+//   -n games  stop after this many games
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Prints the spread of `samples`, in microseconds
+static void print_latencies(std::vector<double>& samples) {
+    if (samples.empty()) return;
+    std::ranges::sort(samples);
+    auto at = [&](double q) { return samples[std::min(samples.size() - 1, (size_t) (q * (double) samples.size()))] * 1e6; };
+    double total = 0;
+    for (double s : samples) total += s;
+    std::cout << std::fixed << std::setprecision(1) << "get_move  " << samples.size() << " positions  "
+              << samples.size() / total << " moves/s  us: mean " << total / (double) samples.size() * 1e6
+              << "  p50 " << at(.5) << "  p90 " << at(.9) << "  p99 " << at(.99) << "  max " << samples.back() * 1e6
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> files;
+    int level = 0;
+    long max_games = -1;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-l") && i + 1 < argc) level = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-n") && i + 1 < argc) max_games = std::stol(argv[++i]);
+        else files.emplace_back(argv[i]);
+    }
+    if (files.empty() || level < 0 || level > 6) {
+        std::cerr << "Usage: go_replay <file>... [-l level] [-n games]" << std::endl;
+        return 1;
+    }
+    std::srand(1);
+
+    long games = 0, skipped = 0, moves = 0, illegal = 0;
+    size_t bytes = 0;
+    double parse_seconds = 0, replay_seconds = 0;
+    std::vector<double> latencies;
+
+    Board board;
+    std::unique_ptr<Bot> bots[2];
+    if (level) {
+        for (Color c : {BLACK, WHITE}) bots[c] = std::make_unique<Bot>((Bot::BotLevel) (level - 1), c, board);
+    }
+
+    auto replay = [&](const GameView& game) {
+        games++;
+        board.clear();
+        auto start = Clock::now();
+        size_t played = game.replay(board, [&](const Board&, Move) {});
+        replay_seconds += seconds_since(start);
+        moves += (long) played;
+        illegal += played < game.moves.size();
+
+        if (level) {
+            board.clear();
+            game.replay(board, [&](const Board&, Move m) {
+                auto t = Clock::now();
+                bots[m.color()]->get_move();
+                latencies.push_back(seconds_since(t));
+            });
+        }
+    };
+
+    GameRecord game;
+    for (const auto& file : files) {
+        MappedFile mapped(file);
+        if (mapped.view().starts_with("AGGD")) {
+            // Game databases need no parsing, their moves are replayed where they lie
+            GameDb db(file);
+            for (size_t i = 0; i < db.size() && games != max_games; i++) replay(db[i]);
+            continue;
+        }
+
+        SgfReader reader(mapped.view());
+        while (games != max_games) {
+            auto start = Clock::now();
+            bool more;
+            try {
+                more = reader.next(game);
+            } catch (const std::runtime_error& e) {
+                std::cerr << file << " at byte " << reader.offset() << ": " << e.what() << std::endl;
+                break;
+            }
+            parse_seconds += seconds_since(start);
+            if (!more) break;
+            replay(game.view());
+        }
+        skipped += reader.skipped();
+        bytes += reader.offset();
+    }
+
+    std::cout << games << " games  " << skipped << " skipped (not " << size << "x" << size << ")  " << illegal
+              << " stopped at an illegal move" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    // Rates only for what was actually timed, so that an empty or broken input prints no inf or nan
+    if (bytes && parse_seconds > 0)
+        std::cout << "parse     " << (double) bytes / parse_seconds / 1e6 << " MB/s" << std::endl;
+    if (moves && replay_seconds > 0)
+        std::cout << "replay    " << moves << " moves  " << (double) moves / replay_seconds << " moves/s  "
+                  << replay_seconds / (double) moves * 1e9 << " ns/move" << std::endl;
+    print_latencies(latencies);
+    return 0;
+}
@@ -0,0 +1,620 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+#include <set>
+#include <bitset>
+#include <ranges>
+#include <cstring>
+#include <array>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <random>
+
+#include "pattern.h"
+
+enum Color {
+    BLACK, WHITE
+};
+Color operator~(const Color& c) { return c == BLACK ? WHITE : BLACK; }
+
+// Random numbers for the current thread, so parallel searches do not contend on std::rand. Seeded from std::rand,
+// so std::srand still makes single-threaded runs repeatable.
+inline std::mt19937& rng() {
+    thread_local std::mt19937 engine(std::rand());
+    return engine;
+}
+
+inline double random_double() {
+    return std::uniform_real_distribution<double>()(rng());
+}
+
+
+struct Pos {
+    int row, col;
+
+    Pos() : Pos(0, 0) {}
+
+    Pos(int row, int col) : row(row), col(col) {}
+
+    Pos operator+(std::pair<int, int> a) const {
+        return {row + a.first, col + a.second};
+    }
+
+    [[nodiscard]] std::array<Pos, 4> neighbors() const {
+        return {{{row,     col - 1},
+                 {row,     col + 1},
+                 {row - 1, col},
+                 {row + 1, col}}};
+    }
+
+    [[nodiscard]] std::array<Pos, 4> corners() const {
+        return {{{row - 1, col - 1},
+                 {row - 1, col + 1},
+                 {row + 1, col - 1},
+                 {row + 1, col + 1}}};
+    }
+
+    [[nodiscard]] std::array<Pos, 8> locality() const {
+        std::array<Pos, 8> res;
+        for (int i = 0; i < 8; i++) res[i] = *this + l1[i];
+        return res;
+    }
+
+    [[nodiscard]] std::array<Pos, 24> locality2() const {
+        std::array<Pos, 24> res;
+        for (int i = 0; i < 24; i++) res[i] = *this + l2[i];
+        return res;
+    }
+
+    bool operator==(const Pos &other) const = default;
+
+    std::strong_ordering operator<=>(const Pos &other) const {
+        return std::pair{row, col} <=> std::pair{other.row, other.col};
+    }
+
+private:
+    static std::pair<int, int> l1[], l2[];
+};
+
+std::pair<int, int> Pos::l1[] = {{-1, -1},
+                                 {-1, 0},
+                                 {-1, 1},
+                                 {0,  -1},
+                                 {0,  1},
+                                 {1,  -1},
+                                 {1,  0},
+                                 {1,  1}};
+std::pair<int, int> Pos::l2[] = {
+        {-2, -2},
+        {-2, -1},
+        {-2, 0},
+        {-2, 1},
+        {-2, 2},
+        {-1, -2},
+        {-1, -1},
+        {-1, 0},
+        {-1, 1},
+        {-1, 2},
+        {0,  -2},
+        {0,  -1},
+        {0,  1},
+        {0,  2},
+        {1,  -2},
+        {1,  -1},
+        {1,  0},
+        {1,  1},
+        {1,  2},
+        {2,  -2},
+        {2,  -1},
+        {2,  0},
+        {2,  1},
+        {2,  2},
+};
+
+struct Positions {
+    std::set<Pos> elements;
+
+    Positions() = default;
+
+    template<std::ranges::range v> Positions(v e) : elements(e.begin(), e.end()) {} // NOLINT(google-explicit-constructor)
+
+    [[nodiscard]] bool has(Pos p) const {
+        return elements.contains(p);
+    }
+
+    void operator+=(Pos p) {
+        elements.insert(p);
+    }
+
+    bool operator-=(Pos p) {
+        bool res = has(p);
+        elements.erase(p);
+        return res;
+    }
+
+    [[nodiscard]] size_t count() const {
+        return elements.size();
+    }
+
+    [[nodiscard]] Pos getAny() const {
+        return *elements.begin();
+    }
+
+    [[nodiscard]] auto begin() const {
+        return elements.begin();
+    }
+
+    [[nodiscard]] auto end() const {
+        return elements.end();
+    }
+
+    Positions operator+(const Positions &other) const {
+        std::set<Pos> merged = elements;
+        for (auto i: other) merged.insert(i);
+        return {merged};
+    }
+
+    void operator+=(const Positions &other) {
+        for (auto i: other) elements.insert(i);
+    }
+
+    template<std::ranges::range v>
+    void operator-=(v stones) {
+        for (auto i: stones) *this -= i;
+    }
+};
+
+struct _Group {
+    Color color;
+    Positions stones, liberties;
+
+    _Group(Color color, Positions stones, Positions liberties) : color(color), stones(std::move(stones)),
+                                                                 liberties(std::move(liberties)) {}
+
+    _Group(Color color, Pos stone, const Positions& liberties) : _Group(color, Positions(std::array{stone}), liberties) {}
+
+    _Group operator+(const _Group &other) const {
+        _Group res = *this;
+        res += other;
+        return res;
+    }
+    void operator+=(const _Group &other){
+        if (color != other.color) throw std::invalid_argument("Cannot merge groups of different colors");
+        stones += other.stones;
+        liberties += other.liberties;
+        liberties -= stones;
+    }
+
+    [[nodiscard]] size_t numLiberties() const {
+        return liberties.count();
+    }
+
+    [[nodiscard]] bool isDead() const {
+        return numLiberties() == 0;
+    }
+};
+typedef std::shared_ptr<_Group> Group;
+
+//template<int size>
+constexpr int size = 9;
+
+// Zobrist keys for a stone of either color on each point, and for white being the side to move
+inline constexpr auto zobrist_keys = [] {
+    std::array<std::array<uint64_t, size * size>, 2> res{};
+    uint64_t seed = 0x5A0B2157ull;
+    for (auto& color : res) for (auto& key : color) key = splitmix64(seed);
+    return res;
+}();
+inline constexpr uint64_t zobrist_white_to_move = [] {
+    uint64_t seed = 0x5A0B2157ull ^ 1;
+    return splitmix64(seed);
+}();
+
+// Where each point (row * size + col) ends up under each of the 8 board symmetries, numbered as in pattern.h
+inline constexpr auto point_symmetries = [] {
+    std::array<std::array<int, size * size>, 8> res{};
+    for (int s = 0; s < 8; s++) for (int row = 0; row < size; row++) for (int col = 0; col < size; col++) {
+        int r = row, c = col;
+        if (s & 4) std::swap(r, c);
+        if (s & 1) r = size - 1 - r;
+        if (s & 2) c = size - 1 - c;
+        res[s][row * size + col] = r * size + c;
+    }
+    return res;
+}();
+
+// The symmetry that undoes `symmetry`: the flips come before the swap, so they trade places
+constexpr int inverse_symmetry(int symmetry) {
+    return symmetry & 4 ? 4 | (symmetry & 1) << 1 | (symmetry & 2) >> 1 : symmetry;
+}
+struct Board {
+    static bool is_pos_valid(Pos pos) {
+        return pos.row >= 0 && pos.row < size && pos.col >= 0 && pos.col < size;
+    }
+
+    std::array<std::array<Group, size>, size> grid;
+    std::set<Group> activeGroups;
+
+    // Packed 3x3 neighbourhood and 5x5 neighbourhood hashes (as is and with colors swapped) of every point,
+    // not counting the edge of the board, which is added back in by locality_code() and locality2_hash()
+    std::array<std::array<uint16_t, size>, size> locality_codes{};
+    std::array<std::array<std::array<uint64_t, 2>, size>, size> locality2_hashes{};
+
+    // Zobrist hashes of the stones on the board as it is and under each of the other symmetries
+    std::array<uint64_t, 8> hashes{};
+
+    // How many groups of each color have each number of liberties, kept up to date as groups change
+    std::array<std::array<uint8_t, size * size>, 2> liberty_counts{};
+
+    // Empty points the enemy of a color cannot safely play: all four sides are its stones or the edge (an eye),
+    // or all but one, which is empty (a mouth, where a stone would be in atari at once)
+    enum Shape { EYE, MOUTH, NUM_SHAPES };
+    std::array<std::array<uint8_t, NUM_SHAPES>, 2> shape_counts{};
+
+    Board() = default;
+
+    bool place_stone(Color color, Pos pos) {
+        // Check simple invalid placement
+        if (!is_pos_valid(pos) || grid[pos.row][pos.col]) return false;
+
+        // Classify adjacent positions
+        std::set<Group> adj_friends, adj_enemies;
+        Positions newLiberties;
+        for (auto p : pos.neighbors()) if (is_pos_valid(p)) {
+            auto group = grid[p.row][p.col];
+            if (group) {
+                (group->color == color ? adj_friends : adj_enemies).insert(group);
+            } else newLiberties += p;
+        }
+
+        // Merge friends with stone
+        auto new_group = std::make_shared<_Group>(color, pos, newLiberties);
+        for (const auto& e : adj_friends) *new_group += *e;
+
+        // Check suicide rule (capturing an enemy frees up a liberty)
+        if (new_group->isDead() && std::ranges::none_of(adj_enemies, [](const Group& e) { return e->numLiberties() == 1; }))
+            return false;
+
+        // Update self state
+
+        for (const auto& e : adj_friends) {
+            activeGroups.erase(e);
+            count_liberties(*e, -1);
+        }
+
+        // Put group on grid
+        activeGroups.insert(new_group);
+        count_liberties(*new_group, 1);
+        for (auto p : new_group->stones) grid[p.row][p.col] = new_group;
+        toggle_localities(color, pos);
+
+        // Update enemies
+        for (const auto& enemy : adj_enemies){
+            count_liberties(*enemy, -1);
+            enemy->liberties -= pos;
+            if (enemy->isDead()) removeDeadGroup(enemy);
+            else count_liberties(*enemy, 1);
+        }
+
+        return true;
+    }
+
+    void removeDeadGroup(Group g){
+        activeGroups.erase(g);
+        for (auto p: g->stones) {
+            getGroupPtr(p).reset();
+            toggle_localities(g->color, p);
+        }
+        // Give the freed points back to the groups around them
+        for (auto p: g->stones) for (auto n : p.neighbors()) {
+            if (!is_pos_valid(n) || !getGroupPtr(n)) continue;
+            count_liberties(*getGroupPtr(n), -1);
+            getGroupPtr(n)->liberties += p;
+            count_liberties(*getGroupPtr(n), 1);
+        }
+    }
+
+    // Fewest liberties of any group of `color`, or nothing if it has no stones on the board
+    [[nodiscard]] std::optional<int> min_liberties(Color color) const {
+        for (int libs = 1; libs < size * size; libs++) if (liberty_counts[color][libs]) return libs;
+        return std::nullopt;
+    }
+
+    // The shape `color` makes around an empty point, from its 3x3 neighbourhood as given by locality_code()
+    static std::optional<Shape> shape_of(uint16_t code, Color color) {
+        int own = 0, empty = 0;
+        for (int i : {1, 3, 4, 6}) {
+            int state = (code >> (2 * i)) & 3;
+            own += state == color + 1 || state == 3;
+            empty += state == 0;
+        }
+        if (own == 4) return EYE;
+        if (own == 3 && empty == 1) return MOUTH;
+        return std::nullopt;
+    }
+
+    void clear() {
+        for(auto& i : grid) for(auto& x : i) x.reset();
+        activeGroups.clear();
+        locality_codes = {};
+        locality2_hashes = {};
+        hashes = {};
+        liberty_counts = {};
+        shape_counts = {};
+    }
+
+    [[nodiscard]] int num_empty() const {
+        int res = 0;
+        for (auto& row : grid) for (auto& g : row) res += !g;
+        return res;
+    }
+
+    // Whether a stone placed here would have no liberties and capture nothing
+    [[nodiscard]] bool is_suicide(Color color, Pos pos) const {
+        for (auto p : pos.neighbors()) if (is_pos_valid(p)) {
+            const Group& group = getGroupPtr(p);
+            if (!group) return false;
+            if (group->color == color ? group->numLiberties() > 1 : group->numLiberties() == 1) return false;
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool is_valid_move(Color color, Pos pos) const {
+        return is_pos_valid(pos) && !getGroupPtr(pos) && !is_suicide(color, pos);
+    }
+
+    // Whether a stone placed here would take the last liberty of an enemy group
+    [[nodiscard]] bool is_capture(Color color, Pos pos) const {
+        return std::ranges::any_of(pos.neighbors(), [&](Pos p) {
+            return is_pos_valid(p) && getGroupPtr(p) && getGroupPtr(p)->color != color && getGroupPtr(p)->numLiberties() == 1;
+        });
+    }
+
+    // 3x3 neighbourhood of a point in the format of pattern.h, with the side to move playing black
+    [[nodiscard]] uint16_t locality_code(Pos p, Color to_move) const {
+        uint16_t code = locality_codes[p.row][p.col] | edge_localities().first[p.row][p.col];
+        return to_move == BLACK ? code : swap_locality_colors(code);
+    }
+
+    // Zobrist hash of the position with `to_move` to play, as the board is or under a symmetry
+    [[nodiscard]] uint64_t position_hash(Color to_move, int symmetry = 0) const {
+        return to_move == WHITE ? hashes[symmetry] ^ zobrist_white_to_move : hashes[symmetry];
+    }
+
+    // The same for every position that is a rotation or reflection of this one
+    [[nodiscard]] uint64_t canonical_hash(Color to_move) const {
+        return position_hash(to_move, canonical_symmetry(to_move));
+    }
+
+    // The symmetry taking this position to its canonical form. Moves map into that form with Move::transform(s)
+    // and back with Move::transform(inverse_symmetry(s)).
+    [[nodiscard]] int canonical_symmetry(Color to_move) const {
+        int res = 0;
+        for (int s = 1; s < 8; s++) if (position_hash(to_move, s) < position_hash(to_move, res)) res = s;
+        return res;
+    }
+
+    static Pos transform(Pos p, int symmetry) {
+        int point = point_symmetries[symmetry][p.row * size + p.col];
+        return {point / size, point % size};
+    }
+
+    // Hash of the 5x5 neighbourhood of a point, with the side to move playing black
+    [[nodiscard]] uint64_t locality2_hash(Pos p, Color to_move) const {
+        return locality2_hashes[p.row][p.col][to_move] ^ edge_localities().second[p.row][p.col];
+    }
+
+    [[nodiscard]] Group& getGroupPtr(Pos p){
+        return grid[p.row][p.col];
+    }
+    [[nodiscard]] const Group& getGroupPtr(Pos p) const {
+        return grid[p.row][p.col];
+    }
+    [[nodiscard]] Group& operator[](Pos p){
+        return getGroupPtr(p);
+    }
+    [[nodiscard]] const Group& operator[](Pos p) const {
+        return getGroupPtr(p);
+    }
+
+    [[nodiscard]] Board copy() const {
+        Board res;
+        for(const Group& group : activeGroups){
+            Group copy {new _Group{*group}};
+            res.activeGroups.insert(copy);
+            for(Pos p : copy->stones){
+                res[p] = copy;
+            }
+        }
+        res.locality_codes = locality_codes;
+        res.locality2_hashes = locality2_hashes;
+        res.hashes = hashes;
+        res.liberty_counts = liberty_counts;
+        res.shape_counts = shape_counts;
+        return res;
+    }
+
+    // One line per row, 'X' for black, 'O' for white and '.' for empty
+    [[nodiscard]] std::string to_string() const {
+        std::string res;
+        for (int row = 0; row < size; row++) {
+            for (int col = 0; col < size; col++) res += grid[row][col] ? "XO"[grid[row][col]->color] : '.';
+            res += '\n';
+        }
+        return res;
+    }
+
+    // Reads the format of to_string(), ignoring anything other than 'X', 'O' and '.'
+    static Board from_string(std::string_view s) {
+        Board res;
+        int i = 0;
+        for (char c : s) {
+            if (c != 'X' && c != 'O' && c != '.') continue;
+            if (i == size * size) throw std::invalid_argument("Too many points in board string");
+            if (c != '.') {
+                Color color = c == 'X' ? BLACK : WHITE;
+                // A capture would quietly take a dead stone placed earlier off the board
+                if (res.is_capture(color, {i / size, i % size}) || !res.place_stone(color, {i / size, i % size}))
+                    throw std::invalid_argument("Stone without liberties in board string");
+            }
+            i++;
+        }
+        if (i != size * size) throw std::invalid_argument("Too few points in board string");
+        return res;
+    }
+
+private:
+    void count_liberties(const _Group& group, int delta) {
+        liberty_counts[group.color][group.numLiberties()] += delta;
+    }
+
+    void count_shapes(Pos p, int delta) {
+        uint16_t code = locality_code(p, BLACK);
+        for (Color color : {BLACK, WHITE}) if (auto shape = shape_of(code, color)) shape_counts[color][*shape] += delta;
+    }
+
+    // Adds or removes a stone from the hash and the neighbourhoods of the points around it
+    void toggle_localities(Color color, Pos pos) {
+        for (int s = 0; s < 8; s++) hashes[s] ^= zobrist_keys[color][point_symmetries[s][pos.row * size + pos.col]];
+        // Only empty points have a shape, and the point itself has just been filled or emptied
+        bool placed = (bool) getGroupPtr(pos);
+        if (placed) count_shapes(pos, -1);
+        auto l1 = pos.locality();
+        for (int i = 0; i < locality_size; i++) if (is_pos_valid(l1[i])) {
+            bool empty = !getGroupPtr(l1[i]);
+            if (empty) count_shapes(l1[i], -1);
+            // pos is at the mirrored index in the neighbour's own neighbourhood
+            locality_codes[l1[i].row][l1[i].col] ^= (uint16_t) ((color + 1) << (2 * (locality_size - 1 - i)));
+            if (empty) count_shapes(l1[i], 1);
+        }
+        if (!placed) count_shapes(pos, 1);
+        auto l2 = pos.locality2();
+        for (int i = 0; i < locality2_size; i++) if (is_pos_valid(l2[i])) {
+            auto& hashes = locality2_hashes[l2[i].row][l2[i].col];
+            hashes[0] ^= locality2_keys[locality2_size - 1 - i][color];
+            hashes[1] ^= locality2_keys[locality2_size - 1 - i][~color];
+        }
+    }
+
+    // Contribution of the off-board points to each point's neighbourhood
+    typedef std::pair<std::array<std::array<uint16_t, size>, size>, std::array<std::array<uint64_t, size>, size>> EdgeLocalities;
+    static const EdgeLocalities& edge_localities() {
+        static const EdgeLocalities res = [] {
+            EdgeLocalities res{};
+            for (int row = 0; row < size; row++) for (int col = 0; col < size; col++) {
+                Pos pos{row, col};
+                auto l1 = pos.locality();
+                for (int i = 0; i < locality_size; i++)
+                    if (!is_pos_valid(l1[i])) res.first[row][col] |= (uint16_t) (3 << (2 * i));
+                auto l2 = pos.locality2();
+                for (int i = 0; i < locality2_size; i++)
+                    if (!is_pos_valid(l2[i])) res.second[row][col] ^= locality2_keys[i][2];
+            }
+            return res;
+        }();
+        return res;
+    }
+};
+
+// A move packed into 16 bits: the point index (row * size + col) in the low 10 bits, then the type and the color
+struct Move {
+    enum MoveType { PLACE, PASS, RESIGN };
+
+    Move() = default;
+
+    static Move play_at(Color color, Pos p){
+        return {color, p.row * size + p.col, PLACE};
+    }
+    static Move pass(Color color){
+        return {color, 0, PASS};
+    }
+    static Move resign(Color color){
+        return {color, 0, RESIGN};
+    }
+
+    [[nodiscard]] Color color() const {
+        return (Color) (bits >> 12);
+    }
+    [[nodiscard]] MoveType type() const {
+        return (MoveType) (bits >> 10 & 3);
+    }
+    [[nodiscard]] int point() const {
+        return bits & 0x3FF;
+    }
+    [[nodiscard]] Pos pos() const {
+        return {point() / size, point() % size};
+    }
+
+    // The same move on the board under a symmetry
+    [[nodiscard]] Move transform(int symmetry) const {
+        return type() == PLACE ? play_at(color(), Board::transform(pos(), symmetry)) : *this;
+    }
+
+    bool operator==(const Move &other) const = default;
+
+private:
+    uint16_t bits{};
+
+    Move(Color c, int point, MoveType t) : bits((uint16_t) (c << 12 | t << 10 | point)) {}
+};
+static_assert(sizeof(Move) == 2 && size * size <= 0x400);
+
+// A move in the frame of board.canonical_symmetry(). When the position is itself symmetric, equivalent moves all
+// map to the same one.
+inline Move canonical_move(const Board& board, Color to_move, Move m) {
+    uint64_t hash = board.canonical_hash(to_move);
+    Move res = m.transform(board.canonical_symmetry(to_move));
+    for (int s = 0; s < 8; s++) if (board.position_hash(to_move, s) == hash) {
+        Move alt = m.transform(s);
+        if (alt.point() < res.point()) res = alt;
+    }
+    return res;
+}
+
+// Fixed-capacity list of moves kept on the stack, with room for one move per point
+struct MoveList {
+    std::array<Move, ::size * ::size> moves;
+    int length = 0;
+
+    void push_back(Move m) {
+        moves[length++] = m;
+    }
+
+    [[nodiscard]] bool contains(Move m) const {
+        return std::find(begin(), end(), m) != end();
+    }
+
+    void clear() {
+        length = 0;
+    }
+
+    [[nodiscard]] int size() const {
+        return length;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return length == 0;
+    }
+
+    [[nodiscard]] Move operator[](int i) const {
+        return moves[i];
+    }
+
+    [[nodiscard]] const Move* begin() const {
+        return moves.data();
+    }
+
+    [[nodiscard]] const Move* end() const {
+        return moves.data() + length;
+    }
+
+    [[nodiscard]] Move random() const {
+        return moves[rng()() % length];
+    }
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "go.h"
+#include "game_record.h"
+#include "mapped_file.h"
+
+// Compact binary collection of games, read by mapping the file and handing out views of the moves in place.
+//
+// Layout, in native (little-endian) byte order:
+//   header  "AGGD", uint32 version 1, uint64 number of games, uint64 offset of the index
+//   games   each a uint16 count of setup stones and a uint16 result (0 unknown, 1 black won, 2 white won),
+//           then the setup stones and the moves as packed 16-bit Moves
+//   index   uint64 offset of every game and then of the end of the last one, 8-byte aligned
+
+static_assert(std::endian::native == std::endian::little && std::is_trivially_copyable_v<Move>);
+
+class GameDb {
+public:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t num_games, index_offset;
+    };
+
+    struct GameHeader {
+        uint16_t num_setup, result;
+    };
+
+private:
+    MappedFile file;
+    const uint64_t* offsets = nullptr;
+    size_t num_games = 0;
+
+public:
+    explicit GameDb(const std::string& path) : file(path) {
+        std::string_view data = file.view();
+        Header header{};
+        if (data.size() < sizeof header) throw std::runtime_error("Not a game database: " + path);
+        std::memcpy(&header, data.data(), sizeof header);
+        if (std::string_view(header.magic, 4) != "AGGD" || header.version != 1)
+            throw std::runtime_error("Not a game database: " + path);
+
+        num_games = header.num_games;
+        if (header.index_offset % 8 || header.index_offset > data.size() ||
+            num_games >= (data.size() - header.index_offset) / 8) // Room for num_games + 1 offsets, without overflow
+            throw std::runtime_error("Truncated game database " + path);
+        offsets = reinterpret_cast<const uint64_t*>(data.data() + header.index_offset);
+        for (size_t i = 0; i < num_games; i++) {
+            bool ok = offsets[i] >= sizeof header && offsets[i] % 2 == 0 && offsets[i + 1] <= header.index_offset &&
+                      offsets[i + 1] >= offsets[i] + sizeof(GameHeader) && (offsets[i + 1] - offsets[i]) % 2 == 0;
+            if (!ok || offsets[i + 1] < offsets[i] + sizeof(GameHeader) + 2 * game_header(i).num_setup ||
+                game_header(i).result > 2 || !valid_moves((*this)[i]))
+                throw std::runtime_error("Corrupt game database " + path + " at game " + std::to_string(i));
+        }
+    }
+
+    [[nodiscard]] size_t size() const {
+        return num_games;
+    }
+
+    [[nodiscard]] GameView operator[](size_t i) const {
+        auto header = game_header(i);
+        auto* first = reinterpret_cast<const Move*>(file.view().data() + offsets[i] + sizeof header);
+        auto* last = reinterpret_cast<const Move*>(file.view().data() + offsets[i + 1]);
+        GameView res{{first, header.num_setup}, {first + header.num_setup, last}, std::nullopt};
+        if (header.result) res.winner = (Color) (header.result - 1);
+        return res;
+    }
+
+    // Views of the games in order
+    class iterator {
+        const GameDb* db;
+        size_t i;
+
+    public:
+        iterator(const GameDb* db, size_t i) : db(db), i(i) {}
+
+        GameView operator*() const {
+            return (*db)[i];
+        }
+
+        iterator& operator++() {
+            i++;
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const = default;
+    };
+
+    [[nodiscard]] iterator begin() const {
+        return {this, 0};
+    }
+
+    [[nodiscard]] iterator end() const {
+        return {this, num_games};
+    }
+
+private:
+    // Replaying a move with a bad colour or point would index past the board's tables
+    static bool valid_moves(const GameView& game) {
+        auto valid = [](Move m) { return m.color() <= WHITE && m.type() <= Move::RESIGN && m.point() < ::size * ::size; };
+        return std::ranges::all_of(game.setup, valid) && std::ranges::all_of(game.moves, valid);
+    }
+
+    [[nodiscard]] GameHeader game_header(size_t i) const {
+        GameHeader res{};
+        std::memcpy(&res, file.view().data() + offsets[i], sizeof res);
+        return res;
+    }
+};
+
+// Streams games into a new database; nothing is readable until close()
+class GameDbWriter {
+    std::string path;
+    std::ofstream out;
+    std::vector<uint64_t> offsets;
+    bool closed = false;
+
+public:
+    explicit GameDbWriter(const std::string& path) : path(path), out(path, std::ios::binary) {
+        if (!out) throw std::runtime_error("Cannot create game database " + path);
+        GameDb::Header header{};
+        out.write(reinterpret_cast<const char*>(&header), sizeof header);
+        offsets.push_back(sizeof header);
+    }
+
+    GameDbWriter(const GameDbWriter&) = delete;
+
+    ~GameDbWriter() {
+        try {
+            close();
+        } catch (const std::runtime_error&) {}
+    }
+
+    void add(const GameView& game) {
+        if (game.setup.size() > UINT16_MAX) throw std::runtime_error("Too many setup stones for a game database");
+        GameDb::GameHeader header{(uint16_t) game.setup.size(), (uint16_t) (game.winner ? *game.winner + 1 : 0)};
+        out.write(reinterpret_cast<const char*>(&header), sizeof header);
+        out.write(reinterpret_cast<const char*>(game.setup.data()), (std::streamsize) game.setup.size_bytes());
+        out.write(reinterpret_cast<const char*>(game.moves.data()), (std::streamsize) game.moves.size_bytes());
+        offsets.push_back(offsets.back() + sizeof header + game.setup.size_bytes() + game.moves.size_bytes());
+    }
+
+    [[nodiscard]] size_t size() const {
+        return offsets.size() - 1;
+    }
+
+    // Writes the index and header
+    void close() {
+        if (closed) return;
+        closed = true;
+        uint64_t index_offset = (offsets.back() + 7) / 8 * 8;
+        out.write("\0\0\0\0\0\0\0", (std::streamsize) (index_offset - offsets.back()));
+        out.write(reinterpret_cast<const char*>(offsets.data()), (std::streamsize) (offsets.size() * sizeof(uint64_t)));
+
+        GameDb::Header header{{'A', 'G', 'G', 'D'}, 1, size(), index_offset};
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof header);
+        out.close();
+        if (!out) throw std::runtime_error("Cannot write game database " + path);
+    }
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <span>
+#include <optional>
+#include "board.h"
+
+// One game on our board: the stones set up before play, then the moves in order. Views may point straight into a
+// memory-mapped GameDb.
+struct GameView {
+    std::span<const Move> setup;
+    std::span<const Move> moves;
+    std::optional<Color> winner;
+
+    // Plays the game onto `board` through place_stone, calling `f(board, move)` before each move. Stops at the
+    // first illegal move and returns how many moves were played.
+    template<typename F>
+    size_t replay(Board& board, F f) const {
+        for (Move m : setup) board.place_stone(m.color(), m.pos());
+        size_t played = 0;
+        for (Move m : moves) {
+            f(board, m);
+            if (m.type() == Move::PLACE && !board.place_stone(m.color(), m.pos())) break;
+            played++;
+        }
+        return played;
+    }
+};
+
+// A game being read or played, which owns its moves
+struct GameRecord {
+    std::vector<Move> setup;
+    std::vector<Move> moves;
+    std::optional<Color> winner;
+
+    void clear() {
+        setup.clear();
+        moves.clear();
+        winner.reset();
+    }
+
+    [[nodiscard]] GameView view() const {
+        return {setup, moves, winner};
+    }
+
+    template<typename F>
+    size_t replay(Board& board, F f) const {
+        return view().replay(board, f);
+    }
+};
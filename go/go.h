@@ -3,564 +3,795 @@
 #include <memory>
 #include <utility>
 #include <vector>
-#include <set>
-#include <memory>
+#include <array>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <cstdint>
+#include <atomic>
+#include <limits>
+#include <functional>
+#include <future>
+#include <stop_token>
+#include <mutex>
 #include <bitset>
-#include <ranges>
-#include <cstring>
-
-enum Color {
-    BLACK, WHITE
-};
-Color operator~(const Color& c) { return c == BLACK ? WHITE : BLACK; }
-
-
-struct Pos {
-    int row, col;
-
-    Pos() : Pos(0, 0) {}
+#include <cmath>
+#include <span>
 
-    Pos(int row, int col) : row(row), col(col) {}
-
-    Pos operator+(std::pair<int, int> a) const {
-        return {row + a.first, col + a.second};
-    }
-
-    std::vector<Pos> neighbors() {
-        return {{row,     col - 1},
-                {row,     col + 1},
-                {row - 1, col},
-                {row + 1, col}};
-    }
-
-    std::vector<Pos> corners() {
-        return {{row - 1, col - 1},
-                {row - 1, col + 1},
-                {row + 1, col - 1},
-                {row + 1, col + 1}};
-    }
+#include "board.h"
+#include "move_stats.h"
+#include "opening_book.h"
+#include "pattern.h"
+#include "solver.h"
+#include "stats.h"
+#include "thread_pool.h"
 
-    std::vector<Pos> locality() {
-        std::vector<Pos> res(8);
-        for (int i = 0; i < 8; i++) res[i] = *this + l1[i];
-        return res;
-    }
+//template<int size>
+class Bot {
+public:
+    enum BotLevel {
+        JOKE, EASY, MEDIUM, HARD, CRAZY, DEMON
+    };
 
-    std::vector<Pos> locality2() {
-        std::vector<Pos> res(24);
-        for (int i = 0; i < 24; i++) res[i] = *this + l2[i];
-        return res;
-    }
+    // Everything that sets one level apart from another, for bots that need custom settings
+    struct Settings {
+        int mcts_visits{}, minimax_depth{}; // Monte carlo playouts per candidate, at most max_mcts_visits
+        int ladder_depth{}, anti_ladder_depth{}; // Most ataris find_forced_capture plays in a row, for us or the enemy
+        bool anti_ladder_nearest{}, can_resign{}, minimax_ladder{};
+        double capture_prob = 1; // Chance of taking a capture when one is available
+        int solver_empty_points{}; // Solve the game exactly once this few points are empty
+        bool minimax_shapes{}; // Score minimax leaves by shape too, not just by the weakest groups
+    };
 
-    std::strong_ordering operator<=>(const Pos &other) const {
-        return std::pair{row, col} <=> std::pair{other.row, other.col};
+    static Settings level_settings(BotLevel level) {
+        Settings s;
+        switch (level) {
+            case JOKE:
+                s.mcts_visits = 5;
+                break;
+            case EASY:
+                s.mcts_visits = 50;
+                s.minimax_depth = 1;
+                s.ladder_depth = s.anti_ladder_depth = 4;
+                break;
+            case MEDIUM:
+                s.mcts_visits = 100;
+                s.minimax_depth = 1;
+                s.ladder_depth = s.anti_ladder_depth = 12;
+                s.solver_empty_points = 10;
+                break;
+            case HARD:
+                s.mcts_visits = 100;
+                s.minimax_depth = 1;
+                s.ladder_depth = s.anti_ladder_depth = 12;
+                s.anti_ladder_nearest = s.can_resign = true;
+                s.solver_empty_points = 12;
+                break;
+            case CRAZY:
+                s.mcts_visits = 250;
+                s.minimax_depth = 1;
+                s.ladder_depth = s.anti_ladder_depth = 16;
+                s.anti_ladder_nearest = s.minimax_ladder = s.can_resign = true;
+                s.solver_empty_points = 16;
+                break;
+            case DEMON:
+                s.mcts_visits = 500;
+                s.minimax_depth = 2;
+                s.ladder_depth = s.anti_ladder_depth = 16;
+                s.anti_ladder_nearest = s.can_resign = true;
+                s.solver_empty_points = 20;
+                break;
+        }
+        return s;
     }
 
 private:
-    static std::pair<int, int> l1[], l2[];
-};
-
-std::pair<int, int> Pos::l1[] = {{-1, -1},
-                                 {-1, 0},
-                                 {-1, 1},
-                                 {0,  -1},
-                                 {0,  1},
-                                 {1,  -1},
-                                 {1,  0},
-                                 {1,  1}};
-std::pair<int, int> Pos::l2[] = {
-        {-2, -2},
-        {-2, -1},
-        {-2, 0},
-        {-2, 1},
-        {-2, 2},
-        {-1, -2},
-        {-1, -1},
-        {-1, 0},
-        {-1, 1},
-        {-1, 2},
-        {0,  -2},
-        {0,  -1},
-        {0,  1},
-        {0,  2},
-        {1,  -2},
-        {1,  -1},
-        {1,  0},
-        {1,  1},
-        {1,  2},
-        {2,  -2},
-        {2,  -1},
-        {2,  0},
-        {2,  1},
-        {2,  2},
-};
-
-struct Positions {
-    std::set<Pos> elements;
-
-    Positions() = default;
-
-    template<std::ranges::range v> Positions(v e) : elements(e.begin(), e.end()) {} // NOLINT(google-explicit-constructor)
-
-    [[nodiscard]] bool has(Pos p) const {
-        return elements.contains(p);
-    }
+    Board* const board;
+    const Color color;
 
-    void operator+=(Pos p) {
-        elements.insert(p);
-    }
+    int mcts_visits{}, ladder_depth{}, anti_ladder_depth{}, minimax_depth{};
+    bool anti_ladder_nearest{}, can_resign{}, minimax_ladder{};
+    double capture_prob = 1;
+    int solver_empty_points{};
+    bool minimax_shapes{};
 
-    bool operator-=(Pos p) {
-        bool res = has(p);
-        elements.erase(p);
-        return res;
-    }
+    // Positions find_forced_capture may read before giving up
+    static constexpr long threat_search_nodes = 20000;
 
-    [[nodiscard]] size_t count() const {
-        return elements.size();
-    }
+    // Visits after which a monte carlo candidate's own win rate and its all-moves-as-first rate count the same
+    static constexpr double rave_equivalence = 300;
 
-    [[nodiscard]] Pos getAny() const {
-        return *elements.begin();
-    }
+    // Every playout of a search can add to one point's all-moves-as-first counts, and there are at most size * size
+    // candidates, so more visits could overflow MoveStats
+    static constexpr int max_mcts_visits = MoveStats::max_count / (size * size);
 
-    [[nodiscard]] auto begin() const {
-        return elements.begin();
-    }
+    // Monte carlo candidates given playouts from the first round
+    static constexpr int widening_start = 8;
 
-    [[nodiscard]] auto end() const {
-        return elements.end();
-    }
+    // Made on first use, keeping its table from move to move. When NUMA aware, there is one for each node, each
+    // made by a thread on that node so that its table is in local memory.
+    std::vector<std::unique_ptr<EndgameSolver>> solvers;
 
-    Positions operator+(const Positions &other) const {
-        std::set<Pos> merged = elements;
-        for (auto i: other) merged.insert(i);
-        return {merged};
-    }
+    // Searches on the pinned pool, see set_numa_aware
+    bool numa_aware = false;
 
-    void operator+=(const Positions &other) {
-        for (auto i: other) elements.insert(i);
-    }
+    // Biases the moves chosen in random games; uniform unless a learned table is set
+    std::shared_ptr<const PatternTable> patterns = PatternTable::uniform();
 
-    template<std::ranges::range v>
-    void operator-=(v stones) {
-        for (auto i: stones) *this -= i;
-    }
-};
+    // Consulted once the capture checks have found nothing to do, before any search, if set
+    std::shared_ptr<const OpeningBook> book;
 
-struct _Group {
-    Color color;
-    Positions stones, liberties;
+    // Of the last get_move; always zero unless built with ATARI_GO_STATS
+    mutable SearchStats search_stats;
+    double move_score = .5;
 
-    _Group(Color color, Positions stones, Positions liberties) : color(color), stones(std::move(stones)),
-                                                                 liberties(std::move(liberties)) {}
+public:
+    Bot(BotLevel level, Color color, Board& board) : Bot(level_settings(level), color, board) {}
 
-    _Group(Color color, Pos stone, const Positions& liberties) : _Group(color, Positions(std::array{stone}), liberties) {}
+    Bot(const Settings& s, Color color, Board& board)
+            : board(&board), color(color), mcts_visits(std::min(s.mcts_visits, max_mcts_visits)), ladder_depth(s.ladder_depth),
+              anti_ladder_depth(s.anti_ladder_depth), minimax_depth(s.minimax_depth),
+              anti_ladder_nearest(s.anti_ladder_nearest), can_resign(s.can_resign), minimax_ladder(s.minimax_ladder),
+              capture_prob(s.capture_prob), solver_empty_points(s.solver_empty_points), minimax_shapes(s.minimax_shapes) {}
 
-    _Group operator+(const _Group &other) const {
-        _Group res = *this;
-        res += other;
-        return res;
-    }
-    void operator+=(const _Group &other){
-        if (color == other.color) {
-            stones += other.stones;
-            liberties += other.liberties;
-            liberties -= stones;
-        }
-        throw std::invalid_argument("Cannot merge groups of different colors");
-    }
+    // Where a search has got to, reported between rounds of get_move's minimax and monte carlo phases
+    struct Progress {
+        enum Phase { MINIMAX, MCTS } phase;
+        Move best;      // What get_move would return if stopped now
+        int done, total; // Root candidates searched, or playouts played, out of how many
+    };
+    typedef std::function<void(const Progress&)> ProgressCallback;
 
-    [[nodiscard]] size_t numLiberties() const {
-        return liberties.count();
+    void set_patterns(std::shared_ptr<const PatternTable> table) {
+        patterns = std::move(table);
     }
 
-    [[nodiscard]] bool isDead() const {
-        return numLiberties() == 0;
+    void set_opening_book(std::shared_ptr<const OpeningBook> opening_book) {
+        book = std::move(opening_book);
     }
-};
-typedef std::shared_ptr<_Group> Group;
 
-//template<int size>
-constexpr int size = 9;
-struct Board {
-    static bool is_pos_valid(Pos pos) {
-        return pos.row >= 0 && pos.row < size && pos.col >= 0 && pos.col < size;
+    // Whether to search on ThreadPool::pinned(), whose workers stay on one core each, rather than the pool of the
+    // calling thread. Playouts then allocate their boards on the node they run on, and the endgame solver keeps a
+    // table per node. The solver runs on the thread calling get_move, so its node is the one that thread is pinned
+    // to when it comes through get_move_async or get_moves, and otherwise whichever it happens to be running on.
+    void set_numa_aware(bool enable) {
+        numa_aware = enable;
     }
 
-    std::array<std::array<Group, size>, size> grid;
-    std::set<Group> activeGroups;
-
-    Board() = default;
-
-    bool place_stone(Color color, Pos pos) {
-        // Check simple invalid placement
-        if (!is_pos_valid(pos) || !grid[pos.row][pos.col]) return false;
-
-        // Classify adjacent positions
-        std::set<Group> adj_friends, adj_enemies;
-        Positions newLiberties;
-        for (auto p : pos.neighbors()) if (is_pos_valid(p)) {
-            auto group = grid[p.row][p.col];
-            if (group) {
-                (group->color == color ? adj_friends : adj_enemies).insert(group);
-            } else newLiberties += p;
-        }
-
-        // Merge friends with stone
-        auto new_group = std::make_shared<_Group>(color, pos, newLiberties);
-        for (const auto& e : adj_friends) *new_group += *e;
-
-        // Check suicide rule
-        if (new_group->isDead()) return false;
-
-        // Update self state
-
-        for (const auto& e : adj_friends) activeGroups.erase(e);
-
-        // Put group on grid
-        activeGroups.insert(new_group);
-        for (auto p : new_group->stones) grid[p.row][p.col] = new_group;
-
-        // Update enemies
-        for (const auto& enemy : adj_enemies){
-            enemy->liberties -= pos;
-            if (enemy->isDead()) removeDeadGroup(enemy);
-        }
-
-        return true;
+    [[nodiscard]] const SearchStats& stats() const {
+        return search_stats;
     }
 
-    void removeDeadGroup(Group g){
-        activeGroups.erase(g);
-        for (auto p: g->stones) getGroupPtr(p).reset();
+    // How the last get_move rated its move for us, from 0 (a loss) to 1 (a win): 1 for a capture or a capture it
+    // can force, 0 for resigning, the blended win rate when monte carlo chose the move, and 1/2 whenever the
+    // deciding phase has no estimate
+    [[nodiscard]] double score() const {
+        return move_score;
     }
 
-    void clear() {
-        for(auto& i : grid) for(auto& x : i) x.reset();
+    // Everything set_bot_level would need to make another bot like this one
+    [[nodiscard]] Settings settings() const {
+        Settings s;
+        s.mcts_visits = mcts_visits, s.ladder_depth = ladder_depth, s.anti_ladder_depth = anti_ladder_depth;
+        s.minimax_depth = minimax_depth, s.anti_ladder_nearest = anti_ladder_nearest, s.can_resign = can_resign;
+        s.minimax_ladder = minimax_ladder, s.capture_prob = capture_prob, s.solver_empty_points = solver_empty_points;
+        s.minimax_shapes = minimax_shapes;
+        return s;
     }
 
-    [[nodiscard]] Group& getGroupPtr(Pos p){
-        return grid[p.row][p.col];
-    }
-    [[nodiscard]] const Group& getGroupPtr(Pos p) const {
-        return grid[p.row][p.col];
-    }
-    [[nodiscard]] Group& operator[](Pos p){
-        return getGroupPtr(p);
-    }
-    [[nodiscard]] const Group& operator[](Pos p) const {
-        return getGroupPtr(p);
+    [[nodiscard]] ThreadPool& pool() const {
+        return numa_aware ? ThreadPool::pinned() : ThreadPool::current();
     }
 
-    [[nodiscard]] Board copy() const {
-        Board res;
-        res.activeGroups = activeGroups;
-        for(const Group& group : activeGroups){
-            Group copy {new _Group{*group}};
-            for(Pos p : copy->stones){
-                res[p] = copy;
+    bool play(Move m) {
+        return m.type() != Move::PLACE || board->place_stone(m.color(), m.pos());
+    }
+
+    // Runs get_move on the pool and returns straight away. The board must not change until the move is ready.
+    std::future<Move> get_move_async(std::stop_token stop = {}, ProgressCallback on_progress = {}) {
+        auto promise = std::make_shared<std::promise<Move>>();
+        auto res = promise->get_future();
+        pool().submit([this, promise, stop, on_progress = std::move(on_progress)] {
+            try {
+                promise->set_value(get_move(stop, on_progress));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
             }
-        }
+        }, true);
         return res;
     }
-};
-
-struct Move {
-    const Color color;
-    const Pos pos;
-    const enum MoveType { PLACE, RESIGN } type;
-
-    static Move play_at(Color color, Pos p){
-        return {color, p, PLACE};
-    }
-    static Move resign(Color color){
-        return {color, {}, RESIGN};
-    }
-private:
-    Move(Color c, Pos p, MoveType t) : color(c), pos(p), type(t) {}
-};
-
-//template<int size>
-class Bot {
-    enum BotLevel {
-        JOKE, EASY, MEDIUM, HARD, CRAZY, DEMON
-    };
-
-    Board* const board;
-    const Color color;
 
-    int mcts_visits{}, ladder_depth{}, anti_ladder_depth{}, minimax_depth{};
-    bool anti_ladder_nearest{}, can_resign{}, minimax_ladder{};
+    // Once `stop` is requested the search winds down and returns the best move it has found so far.
+    // `on_progress` may be called from any thread, but never from two at once.
+    Move get_move(std::stop_token stop = {}, const ProgressCallback& on_progress = {}) {
+        search_stats.reset();
+        move_score = .5;
+        auto resign = [this] {
+            move_score = 0;
+            return Move::resign(color);
+        };
 
-    Bot(BotLevel level, Color color, Board& board) : board(&board), color(color) {
-        switch (level) {
-            case JOKE:
-                mcts_visits = 5;
-                break;
-            case EASY:
-                mcts_visits = 50;
-                minimax_depth = 1;
-                ladder_depth = anti_ladder_depth = 4;
-                break;
-            case MEDIUM:
-                mcts_visits = 100;
-                minimax_depth = 1;
-                ladder_depth = anti_ladder_depth = 6;
-                break;
-            case HARD:
-                mcts_visits = 100;
-                minimax_depth = 1;
-                ladder_depth = anti_ladder_depth = 6;
-                anti_ladder_nearest = can_resign = true;
-                break;
-            case CRAZY:
-                mcts_visits = 250;
-                minimax_depth = 1;
-                ladder_depth = anti_ladder_depth = 10;
-                anti_ladder_nearest = minimax_ladder = can_resign = true;
-                break;
-            case DEMON:
-                mcts_visits = 500;
-                minimax_depth = 2;
-                ladder_depth = anti_ladder_depth = 10;
-                anti_ladder_nearest = can_resign = true;
-                break;
+        // Whether we passed up a capture, which the phases below must not then play after all
+        bool declined = false;
+        {   // Try to capture if possible
+            SearchStats::Timer timer(search_stats, SearchStats::CAPTURE);
+            MoveList p;
+            if(find_capture_moves(*board, color, p)){
+                if (random_double() < capture_prob) {
+                    move_score = 1;
+                    return p.random();
+                }
+                declined = true;
+            }
         }
-    }
-
-    bool play(Move m) {
-        return m.type != Move::MoveType::PLACE || board->place_stone(m.color, m.pos);
-    }
 
-    Move get_move() {
-        {   // Try to capture if possible
-            Pos p;
-            if(find_capture_move(p)){
-                return Move::play_at(color, p);
+        // Moves proven to lose against best play, kept out of whatever the heuristics below pick unless they
+        // leave nothing else, as are captures once we have passed one up
+        MoveList lost;
+        auto avoid = [&](MoveList& moves) {
+            MoveList res;
+            for (Move m : moves) {
+                if (!lost.contains(m) && !(declined && board->is_capture(color, m.pos()))) res.push_back(m);
+            }
+            if (!res.empty()) moves = res;
+        };
+        if (solver_empty_points > 0 && board->num_empty() <= solver_empty_points) {
+            SearchStats::Timer timer(search_stats, SearchStats::SOLVER);
+            size_t shard = numa_aware ? ThreadPool::current_node() : 0;
+            if (solvers.size() <= shard) solvers.resize(shard + 1);
+            auto& solver = solvers[shard];
+            if (!solver) solver = std::make_unique<EndgameSolver>(200000, 16, &search_stats);
+            solver->reset_budget();
+            bool solved = true, drawn = false;
+            for (int row = 0; row < size; row++) for (int col = 0; col < size; col++) {
+                if (!board->is_valid_move(color, {row, col}) || (declined && board->is_capture(color, {row, col})))
+                    continue;
+                Move m = Move::play_at(color, {row, col});
+                auto res = solver->solve_move(*board, m);
+                if (!res) solved = false;
+                else if (*res == EndgameSolver::WIN) {
+                    move_score = 1;
+                    return m;
+                }
+                else if (*res == EndgameSolver::DRAW) drawn = true;
+                else lost.push_back(m);
             }
+            if (solved && !drawn && !declined && !lost.empty() && can_resign) return resign();
         }
 
         {   // Prevent captures
-            std::vector<Pos> p;
-            if(find_anti_capture_moves(p)){
+            SearchStats::Timer timer(search_stats, SearchStats::ANTI_CAPTURE);
+            MoveList p;
+            if(find_anti_capture_moves(*board, color, p)){
+                avoid(p);
                 if(!p.empty()) {
-                    return Move::play_at(color, p[std::rand() % (int) p.size()]);
+                    return p.random();
                 }
             }
-            else return Move::resign(color);
+            else return resign();
+        }
+
+        // Below the capture checks, so that a book built from few or outside games cannot make us miss a capture or
+        // leave a group in atari
+        if (book) {
+            auto m = book->best_move(*board, color);
+            if (m && !lost.contains(*m) && !(declined && board->is_capture(color, m->pos()))) return *m;
         }
 
         {   // Try to play a ladder if possible
-            Pos p;
-            if(find_ladder_move(p)){
-                return Move::play_at(color, p);
+            SearchStats::Timer timer(search_stats, SearchStats::LADDER);
+            Move p;
+            if(find_forced_capture(*board, color, p, false, !declined) && !lost.contains(p)){
+                move_score = 1;
+                return p;
             }
         }
 
         {   // Prevent ladders
-            std::vector<Pos> p;
-            if(find_anti_ladder_moves(p)){
+            SearchStats::Timer timer(search_stats, SearchStats::ANTI_LADDER);
+            MoveList p;
+            if(find_anti_ladder_moves(*board, color, p)){
+                avoid(p);
                 if(!p.empty()) {
-                    return Move::play_at(color, p[std::rand() % (int) p.size()]);
+                    return p.random();
                 }
             }
-            else return Move::resign(color);
+            else return resign();
         }
 
         // Use minimax
-
         if (minimax_depth > 0) {
-            if ((l = t(l = find_minimax_moves(this.board, e), o)).length > 0) return r = Math.floor(Math.random() * l.length), i = l[r];
-            if (this.can_resign) return Move::resign(color);
+            SearchStats::Timer timer(search_stats, SearchStats::MINIMAX);
+            MoveList p;
+            int score;
+            if (find_minimax_moves(*board, color, p, stop, on_progress, &score)) {
+                avoid(p);
+                // Only a forced win or loss says anything about the chances
+                if (score == 1000 || score == -1000) move_score = score > 0;
+                return p.random();
+            }
+            if (can_resign && !stop.stop_requested()) return resign();
         }
+
+        // Use monte carlo
         if (mcts_visits > 0) {
-            let n;
-            const a = t(new h(this.board, true).list_moves(), o);
-            for (let t of a) if (null == board.grid_get_string(t) && !this.is_point_an_eye(this.board, t, e) && is_valid_move(this.board, t, e)) {
-                    const _ = {
-                            point: t, visits: 0, wins: 0, losses: 0
-                    };
-                    l.length++, l[l.length - 1] = _
-            }
-            if (0 == l.length) return "pass";
-            for (let t = 0; t < l.length; t++) {
-                const set = l[t];
-                for (let t = 0; t < mcts_visits; t++) n = play_random_game(this.board, e, set.point), set.visits++, n == e ? set.wins++ : n == curr(e) && set.losses++
+            SearchStats::Timer timer(search_stats, SearchStats::MCTS);
+            MoveList moves;
+            find_candidate_moves(*board, color, moves);
+            avoid(moves);
+            if (moves.empty()) return Move::pass(color);
+            // Most promising first, as only the first few get playouts to begin with
+            std::vector<std::pair<double, Move>> priors;
+            for (Move m : moves) priors.emplace_back(-move_prior(*board, color, m.pos()), m);
+            std::ranges::stable_sort(priors, {}, &std::pair<double, Move>::first);
+            std::vector<Move> candidates;
+            for (auto [prior, m] : priors) candidates.push_back(m);
+            // Results of the playouts starting with each candidate, and all moves as first: of every playout in
+            // which we played a point, first or later on
+            MoveStats own, amaf;
+
+            // A candidate's own win rate, leaning on its all-moves-as-first rate while it has few visits of its own
+            auto rate = [](MoveStats::Counts c) { return c.wins + c.losses ? (double) c.wins / (c.wins + c.losses) : .5; };
+            auto score = [&](Move m) {
+                MoveStats::Counts c = own.get(m.point());
+                double beta = std::sqrt(rave_equivalence / (3 * c.visits + rave_equivalence));
+                return (1 - beta) * rate(c) + beta * rate(amaf.get(m.point()));
+            };
+            // Progressive widening: the best candidates by prior get playouts from the start, the rest join in a
+            // few more each round
+            int rounds = std::min(mcts_visits, 10), num_candidates = (int) candidates.size();
+            auto unlocked = [&](int round) {
+                return std::min(num_candidates, widening_start + num_candidates * round / rounds);
+            };
+            int active = unlocked(0);
+            auto find_best = [&] {
+                MoveList best;
+                double best_score = -1;
+                for (Move m : std::span(candidates).first(active)) {
+                    double s = score(m);
+                    if (s > best_score) best_score = s, best.clear();
+                    if (s == best_score) best.push_back(m);
+                }
+                return best;
+            };
+
+            // Play the visits in rounds, every playout being a task of its own for the pool, so that all threads stay
+            // busy even while only a few candidates are unlocked
+            auto round_visits = [&](int round) {
+                return mcts_visits * (round + 1) / rounds - mcts_visits * round / rounds;
+            };
+            int total = 0, done = 0;
+            for (int round = 0; round < rounds; round++) total += round_visits(round) * unlocked(round);
+            for (int round = 0; round < rounds && !stop.stop_requested(); round++) {
+                int visits = round_visits(round);
+                active = unlocked(round);
+                pool().parallel_for(0, active * visits, [&](int i) {
+                    Move m = candidates[i % active];
+                    std::bitset<size * size> played;
+                    auto winner = play_random_game(*board, color, m.pos(), &played);
+                    own.add(m.point(), winner == color, winner == ~color);
+                    if (winner) for (int k = 0; k < size * size; k++) if (played[k]) {
+                        amaf.add(k, winner == color, winner == ~color);
+                    }
+                });
+                done += visits * active;
+                if (on_progress) on_progress({Progress::MCTS, find_best()[0], done, total});
             }
+            Move best = find_best().random();
+            move_score = score(best);
+            return best;
+        }
+        return Move::pass(color);
+    }
+
+    struct ScoredMove {
+        Move move;
+        double score; // As score() would give after get_move
+    };
 
-            function d(e) {
-                return l[e].wins / (0 == l[e].losses ? .1 : l[e].losses)
+    // get_move for `color` in each of many positions, with this bot's settings, patterns and book, spread across the
+    // pool. Bots and boards are reused from one position to the next, so each bot (with its endgame solver table) is
+    // set up once per thread instead of once per position, and all of them go once the batch is done. Positions not
+    // reached before `stop` is requested get a pass scored 1/2.
+    std::vector<ScoredMove> get_moves(std::span<const Board> boards, std::stop_token stop = {}) const {
+        struct Scratch {
+            Board board;
+            Bot bot;
+
+            explicit Scratch(const Bot& parent) : bot(parent.settings(), parent.color, board) {
+                bot.set_patterns(parent.patterns);
+                bot.set_opening_book(parent.book);
+                bot.set_numa_aware(parent.numa_aware);
+            }
+        };
+        // Those not in use. A search takes one out while it runs, so a thread that takes up another position while
+        // waiting inside a search gets a second, and one whose search throws frees its own.
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Scratch>> idle;
+
+        std::vector<ScoredMove> res(boards.size(), {Move::pass(color), .5});
+        pool().parallel_for(0, (int) boards.size(), [&](int i) {
+            if (stop.stop_requested()) return;
+            std::unique_ptr<Scratch> scratch;
+            {
+                std::lock_guard lock(mutex);
+                if (!idle.empty()) {
+                    scratch = std::move(idle.back());
+                    idle.pop_back();
+                }
             }
+            if (!scratch) scratch = std::make_unique<Scratch>(*this);
+            scratch->board = boards[i].copy();
+            Move m = scratch->bot.get_move(stop);
+            res[i] = {m, scratch->bot.score()};
+
+            std::lock_guard lock(mutex);
+            idle.push_back(std::move(scratch));
+        });
+        return res;
+    }
+
+    // Building blocks of get_move, exposed for the benchmarks and tools
 
-            let u = Array();
-            u.length = 1, u[0] = 0;
-            let c = d(0), g = 0;
-            for (let e = 1; e < l.length; e++) (g = d(e)) == c ? (u.length++, u[u.length - 1] = e) : g > c && ((u = Array()).length = 1, u[0] = e, c = g);
-            return i = u[r = Math.floor(Math.random() * u.length)], l[i].point
+    // Cheap guess at how good a move is, to pick the monte carlo candidates that get playouts first: its playout
+    // pattern weight, four times that for putting an enemy group in atari and twice for adding a liberty to one of
+    // ours with two, and half as much with no stone next to it, or a quarter with none within two points
+    [[nodiscard]] double move_prior(const Board& b, Color color, Pos p) const {
+        double res = patterns->weight(b.locality_code(p, color), b.locality2_hash(p, color));
+        bool atari = false, save = false;
+        for (Pos n : p.neighbors()) if (Board::is_pos_valid(n) && b[n] && b[n]->numLiberties() == 2) {
+            (b[n]->color == color ? save : atari) = true;
         }
-        return "pass";
+        if (atari) res *= 4;
+        if (save) res *= 2;
+        if (!b.locality_codes[p.row][p.col]) res *= b.locality2_hashes[p.row][p.col][0] ? .5 : .25;
+        return res;
     }
 
-    void play_random_game(e, t, r) {
-        const i = e.board_copy();
-        i.place_stone(t, r);
-        let o, n, a, h = t;
-        const _ = Array();
-        for (let e = 0; e < i.num_cols; e++) for (let t = 0; t < i.num_rows; t++) {
-                let r = new Pos(e, t);
-                null == i.grid_get_string(r) && (_.length++, _[_.length - 1] = r)
+    // Plays random moves, weighted by the pattern around each point, after `color` plays at `pos` until one
+    // side can capture. Returns the winner, or nothing if the board fills up first. Nothing is captured along the
+    // way, so every point `color` played, `pos` included, can be marked in `played`.
+    std::optional<Color> play_random_game(const Board& start, Color color, Pos pos,
+                                          std::bitset<size * size>* played = nullptr) const {
+        search_stats.count(SearchStats::PLAYOUTS);
+        search_stats.count(SearchStats::PLAYOUT_MOVES);
+        search_stats.count(SearchStats::BOARD_COPIES);
+        Board b = start.copy();
+        b.place_stone(color, pos);
+        if (played) played->set(pos.row * size + pos.col);
+
+        // Sampling weights for either side to move, refreshed only around the points that change
+        std::array<std::array<float, size * size>, 2> weights{};
+        std::array<double, 2> totals{};
+        auto refresh = [&](Pos p) {
+            for (Color c : {BLACK, WHITE}) {
+                float w = b[p] ? 0.f : patterns->weight(b.locality_code(p, c), b.locality2_hash(p, c));
+                float& curr = weights[c][p.row * size + p.col];
+                totals[c] += w - curr;
+                curr = w;
+            }
+        };
+        for (int row = 0; row < size; row++) for (int col = 0; col < size; col++) refresh({row, col});
+
+        Color mover = color;
+        Pos last = pos;
+        // Groups the mover left in atari when it had more than one to save
+        std::array<Pos, 4> threatened;
+        int num_threatened = 0;
+        while (true) {
+            Color next = ~mover;
+
+            // Only stones next to the last move can have changed, so there is no need to scan every group
+            if (b[last]->numLiberties() == 1) return next;
+            for (int i = 0; i < num_threatened; i++) if (b[threatened[i]]->numLiberties() == 1) return next;
+            num_threatened = 0;
+
+            std::optional<Pos> move;
+            for (Pos p : last.neighbors()) {
+                if (!Board::is_pos_valid(p) || !b[p] || b[p]->color != next || b[p]->numLiberties() != 1) continue;
+                if (move) threatened[num_threatened++] = p;
+                else move = b[p]->liberties.getAny();
+            }
+
+            if (move) {
+                // Escaping the atari is forced, and decides the game if it cannot work or leads into a net
+                if (!b.place_stone(next, *move)) return mover;
+                if (b[*move]->numLiberties() == 2 && is_net(b, *move, mover)) return mover;
             }
-        while(true) {
-            if (h = curr(h), n = null, isInAtari(i, curr(h))) return h;
-            if (0 == (a = find_anti_capture_moves(i, h))) return curr(h);
-            if (a.length > 0 && (n = a[0]), null != n) for (let e = 0; e < _.length - 1; e++) if (n = _[e]) {
-                        _[e] = _[_.length - 1], _.length--;
-                        break
+            else {
+                // So does leaving the group just played short of liberties in a net
+                if (b[last]->numLiberties() == 2 && is_net(b, last, next)) return next;
+                auto& w = weights[next];
+                while (!move) {
+                    double r = random_double() * totals[next];
+                    int i = -1;
+                    for (int j = 0; j < size * size; j++) if (w[j] > 0) {
+                        i = j;
+                        if ((r -= w[j]) < 0) break;
                     }
-            if (null == n) for (; 0 != _.length && (n = _[o = Math.floor(Math.random() * _.length)], _[o] = _[_.length - 1], _.length--, is_point_an_eye(i, n, h)) && !this.is_valid_move(i, n, h);) ;
-            if (null == n) break;
-            i.place_stone(h, n)
+                    if (i < 0) return std::nullopt;
+
+                    Pos p{i / size, i % size};
+                    if (!is_point_an_eye(b, p, next) && b.place_stone(next, p)) move = p;
+                    else totals[next] -= w[i], w[i] = 0;
+                }
+            }
+
+            search_stats.count(SearchStats::PLAYOUT_MOVES);
+            if (played && next == color) played->set(move->row * size + move->col);
+            refresh(*move);
+            for (Pos p : move->locality2()) if (Board::is_pos_valid(p)) refresh(p);
+            mover = next;
+            last = *move;
         }
-        return;
     }
 
-    bool isInAtari() {
-        for (let r of e.strings) if (r.color == t && 1 == r.num_liberties()) return true;
-        return false
+    // Whether `attacker`, to move, surely captures the group at `p`, which has two liberties: after an atari on one
+    // liberty, extending from the other would leave it at most one. Looks only at the points around the two
+    // liberties, so it misses longer ladders and any atari that needs care to play. Never while the attacker has a
+    // group in atari anywhere, as the defender would answer the atari by capturing it.
+    static bool is_net(const Board& board, Pos p, Color attacker) {
+        if (isInAtari(board, attacker)) return false;
+        const Group& group = board[p];
+        Pos libs[2] = {*group->liberties.begin(), *std::next(group->liberties.begin())};
+        for (int i = 0; i < 2; i++) {
+            Pos atari = libs[i], escape = libs[1 - i];
+            // Our stone has two liberties of its own, and nothing of ours next to the escape can be captured
+            int free = 0;
+            for (Pos n : atari.neighbors()) free += Board::is_pos_valid(n) && n != escape && !board[n];
+            if (free < 2) continue;
+
+            bool safe = true;
+            Positions escape_libs;
+            for (Pos n : escape.neighbors()) if (Board::is_pos_valid(n) && n != atari) {
+                const Group& g = board[n];
+                if (!g) escape_libs += n;
+                else if (g->color == attacker) safe &= g->numLiberties() > 2;
+                else for (Pos l : g->liberties) if (l != atari && l != escape) escape_libs += l;
+            }
+            if (safe && escape_libs.count() <= 1) return true;
+        }
+        return false;
+    }
+
+    static bool isInAtari(const Board& board, Color color) {
+        return std::ranges::any_of(board.activeGroups, [color](const Group& g) {
+            return g->color == color && g->numLiberties() == 1;
+        });
     }
 
-    find_capture_moves(e, t) {
-        const r = new Positions;
-        for (let i of e.strings) if (i.color != t && 1 == i.num_liberties()) {
-            let curr = i.liberties.first();
-            is_move_violates_ko(e, curr, t) || r.add_if_new(curr)
+    // Empty points that are legal and do not fill in one of our own eyes
+    static bool find_candidate_moves(const Board& board, Color color, MoveList& res) {
+        for (int row = 0; row < size; row++) for (int col = 0; col < size; col++) {
+            Pos p{row, col};
+            if (board.is_valid_move(color, p) && !is_point_an_eye(board, p, color)) res.push_back(Move::play_at(color, p));
         }
-        return Array.from(r.elements)
+        return !res.empty();
     }
 
-    find_anti_capture_moves(e, t) {
-        const r = new Positions;
-        for (let i of e.strings) if (i.color == t && 1 == i.num_liberties()) {
-            let curr = i.liberties.first();
-            if (this.is_move_self_capture(this.board, curr, t)) {
-                if (this.can_resign) return false
-            } else r.add_if_new(curr);
-            if (this.can_resign) {
-                let r = e.board_copy();
-                if (r.place_stone(t, curr), isInAtari(r, t)) return false
-            }
+    // Liberties of the groups of `color` in atari, played by `mover`
+    static bool find_atari_liberties(const Board& board, Color color, Color mover, MoveList& res) {
+        for (const Group& group : board.activeGroups) if (group->color == color && group->numLiberties() == 1) {
+            Move m = Move::play_at(mover, group->liberties.getAny());
+            if (!res.contains(m)) res.push_back(m);
         }
-        return Array.from(r.elements)
+        return !res.empty();
     }
 
-    find_ladder_move(e, t, r = 1, i = false) {
-        if (i) {
-            if (r > anti_ladder_depth) return null
-        } else if (r > ladder_depth) return null;
-        for (let r of e.strings) if (r.color != t && 1 == r.num_liberties()) return true;
-        let l = null;
-        for (let a of e.strings) if (a.color != t && 2 == a.num_liberties()) {
-            for (let h of a.liberties.elements) if (this.is_valid_move(e, h, t)) {
-                const o = e.board_copy();
-                if (o.place_stone(t, h), !this.isInAtari(o, t)) {
-                    let n = null;
-                    for (let e of o.strings) e.color != t && 1 == e.num_liberties() && (n = e.liberties.first());
-                    if (null == n) return false;
-                    if (o.place_stone(curr(t), n), find_ladder_move(o, t, r + 1, i)) {
-                        l = h;
-                        break
-                    }
-                }
+    static bool find_capture_moves(const Board& board, Color color, MoveList& res) {
+        return find_atari_liberties(board, ~color, color, res);
+    }
+
+    // Returns false if the situation is hopeless and we would rather resign
+    bool find_anti_capture_moves(const Board& board, Color color, MoveList& res) const {
+        for (const Group& group : board.activeGroups) if (group->color == color && group->numLiberties() == 1) {
+            Pos p = group->liberties.getAny();
+            if (board.is_suicide(color, p)) {
+                if (can_resign) return false;
+                continue;
+            }
+            if (!res.contains(Move::play_at(color, p))) res.push_back(Move::play_at(color, p));
+            if (can_resign) {
+                search_stats.count(SearchStats::BOARD_COPIES);
+                Board next = board.copy();
+                next.place_stone(color, p);
+                if (isInAtari(next, color)) return false;
             }
-            if (null != l) break
         }
-        return null == l ? null : 1 != r || l
+        return true;
     }
 
-    find_anti_ladder_moves(e, t) {
-        let r, i, o = Array();
-        if (null == find_ladder_move(e, curr(t), 1, true)) return o;
-        for (let n = 0; n < e.num_cols; n++) for (let a = 0; a < e.num_cols; a++) i = new Pos(n, a), is_valid_move(e, i, t) && ((r = e.board_copy()).place_stone(t, i),
-                        isInAtari(r, t) || null == find_ladder_move(r, curr(t), 1, true) && (o.length++, o[o.length - 1] = i));
-        if (this.anti_ladder_nearest) {
-            var n = Array();
-            for (let r of o) {
-                var a = false, h = r.neighbors().concat(r.corners());
-                h = r.neighbors();
-                for (let r = 0; r < h.length; r++) {
-                    let i = h[r];
-                    if (e.is_on_grid(i)) {
-                        let r = e.grid_get_string(i);
-                        if (null != r && r.color == t) {
-                            a = true;
-                            break
-                        }
-                    }
+    // Threat-space search for a capture `color` can force, ladders included. We only ever play ataris, which leave
+    // the enemy one reply: extending the group in atari, since it can capture nothing of ours. That keeps the tree
+    // narrow enough to read up to ladder_depth (or anti_ladder_depth) of our ataris deep within a fixed node budget.
+    // Without `captures`, taking what is already in atari does not count as a first move.
+    bool find_forced_capture(const Board& board, Color color, Move& p, bool anti = false, bool captures = true) const {
+        long budget = threat_search_nodes;
+        return threat_search(board, color, anti ? anti_ladder_depth : ladder_depth, budget, p, captures);
+    }
+
+    // Whether `color` can capture now (if `captures`) or force a capture with at most `attacks` ataris, giving the
+    // first move in `p`
+    bool threat_search(const Board& board, Color color, int attacks, long& budget, Move& p, bool captures = true) const {
+        // Whatever is already in atari is ours, as it is our move
+        if (captures) for (const Group& g : board.activeGroups) if (g->color != color && g->numLiberties() == 1) {
+            p = Move::play_at(color, g->liberties.getAny());
+            return true;
+        }
+        if (attacks == 0) return false;
+
+        MoveList tried;
+        for (const Group& group : board.activeGroups) if (group->color != color && group->numLiberties() == 2) {
+            for (Pos h : group->liberties) {
+                Move attack = Move::play_at(color, h);
+                if (tried.contains(attack) || !board.is_valid_move(color, h)) continue;
+                // An atari that also takes a group already in atari is a capture all the same
+                if (!captures && board.is_capture(color, h)) continue;
+                tried.push_back(attack);
+                if (--budget < 0) return false;
+
+                search_stats.count(SearchStats::NODES);
+                search_stats.count(SearchStats::BOARD_COPIES);
+                Board next = board.copy();
+                next.place_stone(color, h);
+                // The enemy would capture first
+                if (isInAtari(next, color)) continue;
+
+                // Two groups in atari on different points cannot both be saved
+                MoveList escapes;
+                find_atari_liberties(next, ~color, ~color, escapes);
+                if (escapes.size() > 1 || !next.place_stone(~color, escapes[0].pos())) {
+                    p = attack;
+                    return true;
                 }
-                a && (n.length++, n[n.length - 1] = r)
+
+                Move unused;
+                if (threat_search(next, color, attacks - 1, budget, unused)) {
+                    p = attack;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Returns false if the enemy has a ladder we cannot stop and we would rather resign
+    bool find_anti_ladder_moves(const Board& board, Color color, MoveList& res) const {
+        Move unused;
+        if (!find_forced_capture(board, ~color, unused, true)) return true;
+
+        // Read the ladder after every move in parallel, then collect the ones that stop it in board order
+        std::array<bool, size * size> stops{};
+        pool().parallel_for(0, size * size, [&](int i) {
+            Pos p{i / size, i % size};
+            if (!board.is_valid_move(color, p)) return;
+            search_stats.count(SearchStats::BOARD_COPIES);
+            Board next = board.copy();
+            next.place_stone(color, p);
+            Move ladder;
+            stops[i] = !isInAtari(next, color) && !find_forced_capture(next, ~color, ladder, true);
+        });
+        for (int i = 0; i < size * size; i++) if (stops[i]) res.push_back(Move::play_at(color, {i / size, i % size}));
+
+        if (anti_ladder_nearest) {
+            MoveList nearest;
+            for (Move m : res) {
+                if (std::ranges::any_of(m.pos().neighbors(), [&](Pos n) {
+                    return Board::is_pos_valid(n) && board[n] && board[n]->color == color;
+                })) nearest.push_back(m);
             }
-            n.length > 0 && (o = n)
+            if (!nearest.empty()) res = nearest;
         }
-        return o
+        return !res.empty() || !can_resign;
+    }
+
+    // Candidates not searched before `stop` is requested are left out. The score they share goes in `value`.
+    bool find_minimax_moves(const Board& board, Color color, MoveList& res, std::stop_token stop = {},
+                            const ProgressCallback& on_progress = {}, int* value = nullptr) const {
+        MoveList candidates;
+        find_candidate_moves(board, color, candidates);
+
+        // Candidates are searched in parallel, sharing the best score so far so that each can give up as soon
+        // as one reply shows it is strictly worse
+        std::atomic<int> alpha = -999;
+        std::array<int, size * size> scores;
+        scores.fill(std::numeric_limits<int>::min());
+        std::mutex progress_mutex;
+        int searched = 0, best_score = std::numeric_limits<int>::min();
+        Move best;
+        pool().parallel_for(0, candidates.size(), [&](int i) {
+            if (stop.stop_requested()) return;
+            int score = scores[i] = minimax_score(board, color, candidates[i].pos(), 1, &alpha);
+            int prev = alpha.load();
+            while (score > prev && !alpha.compare_exchange_weak(prev, score));
+
+            if (on_progress) {
+                std::lock_guard lock(progress_mutex);
+                if (score > best_score) best_score = score, best = candidates[i];
+                on_progress({Progress::MINIMAX, best, ++searched, candidates.size()});
+            }
+        });
+
+        for (int i = 0; i < candidates.size(); i++) if (scores[i] == alpha) res.push_back(candidates[i]);
+        if (value) *value = alpha;
+        return !res.empty();
     }
 
-    find_minimax_moves(const Board& board, Color color) {
+    // Worst outcome for `color` after playing `move`, over all enemy replies. The search stops early, returning an
+    // upper bound instead, once the outcome can no longer matter: when it drops to `floor` (the best our parent has
+    // already found) or below the shared `alpha` (the best found at the root, where ties still count).
+    int minimax_score(const Board& board, Color color, Pos move, int depth, const std::atomic<int>* alpha = nullptr,
+                      int floor = std::numeric_limits<int>::min()) const {
         Color enemy = ~color;
-        
-        function l(board, curr, o, n = 1) {
-            function a(board) {
-                let r, i = null, curr = null;
-                for (let l of e.strings) r = l.num_liberties(), l.color == color ? (null == i || i > r) && (i = r) : (null == curr || curr > r) && (curr = r);
-                return i - curr
-            }
-
-            const h = board.board_copy(), _ = curr.policy_copy();
-            if (h.place_stone(color, o), _.add(h, o), i.isInAtari(h, color)) return -1e3;
-            if (i.ladder_depth > 0 && i.minimax_ladder && null != i.find_ladder_move(h, enemy)) return -1e3;
-            const set = Array();
-            let d = false;
-            for (let e of h.strings) if (board.color == enemy && 1 == board.num_liberties()) {
-                d = true;
-                let t = board.liberties.first();
-                if (i.is_move_self_capture(h, t, enemy)) return 1e3;
-                set.length++, set[set.length - 1] = t
-            }
-            if (d && set.length > 1) return 1e3;
-            if (!d) for (let e of _.list_moves()) i.is_valid_move(h, board, enemy) && !i.is_point_an_eye(h, board, enemy) && (set.length++, set[set.length - 1] = board);
-            let u, c, g, m, w = 1e3;
-            for (let e of set) {
-                u = h.board_copy(), c = _.policy_copy(), u.place_stone(enemy, e), c.add(u, e);
-                const board = i.isInAtari(u, enemy);
-                let v = false;
-                if (!board && i.ladder_depth > 0 && i.minimax_ladder && (v = null != i.find_ladder_move(u, color)), board) g = 1e3; else if (v) g = 1e3; else if (n == i.minimax_depth) g = a(u); else {
-                    g = null;
-                    const p = Array();
-                    let y = false;
-                    for (let e of u.strings) if (e.color == color && 1 == e.num_liberties()) {
-                        y = true;
-                        let r = e.liberties.first();
-                        i.is_move_self_capture(u, r, color) && (g = -1e3), p.length++, p[p.length - 1] = r
+        Move unused;
+
+        search_stats.count(SearchStats::NODES);
+        search_stats.count(SearchStats::BOARD_COPIES);
+        Board after = board.copy();
+        after.place_stone(color, move);
+        if (isInAtari(after, color)) return -1000;
+        if (minimax_ladder && find_forced_capture(after, enemy, unused)) return -1000;
+
+        // The enemy has to save whatever we put in atari
+        MoveList replies;
+        if (find_atari_liberties(after, enemy, enemy, replies)) {
+            if (replies.size() > 1) return 1000;
+            if (after.is_suicide(enemy, replies[0].pos())) return 1000;
+        }
+        else find_candidate_moves(after, enemy, replies);
+
+        int worst = 1000;
+        for (Move reply : replies) {
+            search_stats.count(SearchStats::NODES);
+            search_stats.count(SearchStats::BOARD_COPIES);
+            Board next = after.copy();
+            next.place_stone(enemy, reply.pos());
+
+            std::optional<int> score;
+            if (isInAtari(next, enemy)) score = 1000;
+            else if (minimax_ladder && find_forced_capture(next, color, unused)) score = 1000;
+            else if (depth == minimax_depth) score = minimax_eval(next, color);
+            else {
+                MoveList moves;
+                find_atari_liberties(next, color, color, moves);
+                if (moves.size() > 1 || (moves.size() == 1 && next.is_suicide(color, moves[0].pos()))) score = -1000;
+                else {
+                    if (moves.empty()) find_candidate_moves(next, color, moves);
+                    for (Move m : moves) {
+                        int s = minimax_score(next, color, m.pos(), depth + 1, nullptr,
+                                              score.value_or(std::numeric_limits<int>::min()));
+                        if (!score || s > *score) score = s;
+                        // This reply is already no better for the enemy than one we have seen
+                        if (*score == 1000 || *score >= worst) break;
                     }
-                    if (y && p.length > 1 && (g = -1e3), !y) for (let e of c.list_moves()) i.is_valid_move(u, e, color) && !i.is_point_an_eye(u, e, color) && (p.length++, p[p.length - 1] = e);
-                    if (null == g) for (let e of p) if (m = l(u, c, e, n + 1), (null == g || m > g) && (g = m), 1e3 == g) break
                 }
-                if (null != g && (g < w && (w = g), -1e3 == w)) break
             }
-            return w
+            if (score && (worst = std::min(worst, *score)) == -1000) break;
+            if (worst <= floor || (alpha && worst < alpha->load(std::memory_order_relaxed))) break;
         }
+        return worst;
+    }
+
+    // Our least free group's liberties minus the enemy's. With minimax_shapes, that counts four times over, plus our
+    // eyes (two each) and mouths (one each) minus the enemy's, plus two for each enemy group with two liberties left,
+    // less two for each of ours and four for each of ours in atari. Every term is kept up to date by the board.
+    [[nodiscard]] int minimax_eval(const Board& board, Color color) const {
+        Color enemy = ~color;
+        int libs = board.min_liberties(color).value_or(0) - board.min_liberties(enemy).value_or(0);
+        if (!minimax_shapes) return libs;
 
-        var o, n = -999, a = Array(), _ = Array(), set = new h(board);
-        for (let r of set.list_moves()) is_valid_move(board, enemy, color) && !this.is_point_an_eye(board, enemy, color) && (_.length++, _[_.length - 1] = enemy);
-        for (let t of _) (o = l(board, set, t)) > n && (n = o, a = Array()), o == n && (a.length++, a[a.length - 1] = t);
-        return a
+        const auto& own = board.shape_counts[color];
+        const auto& other = board.shape_counts[enemy];
+        int shapes = 2 * (own[Board::EYE] - other[Board::EYE]) + own[Board::MOUTH] - other[Board::MOUTH];
+        int threats = board.liberty_counts[enemy][2] - board.liberty_counts[color][2] - 2 * board.liberty_counts[color][1];
+        return 4 * libs + shapes + 2 * threats;
     }
 
     static bool is_point_an_eye(const Board& board, Pos pos, Color color) {
         if (board.getGroupPtr(pos)) return false;
 
         for (auto p : pos.neighbors())
-            if (Board::is_pos_valid(p) && board[p]->color != color)
+            if (Board::is_pos_valid(p) && (!board[p] || board[p]->color != color))
                 return false;
 
         int num_corners = 0, side_corners = 0;
@@ -568,7 +799,7 @@ class Bot {
 
         for (Pos p : pos.corners()) {
             if (Board::is_pos_valid(p)) {
-                if (board[p]->color == color)
+                if (board[p] && board[p]->color == color)
                     num_corners++;
             } else {
                 is_center_eye = false;
@@ -578,49 +809,3 @@ class Bot {
         return is_center_eye ? num_corners >= 3 : side_corners + num_corners == 4;
     }
 };
-
-
-/*
-        var d = Array();
-onmessage = function (e) {
-    const t = e.data.command;
-    let r = "", i = "";
-    if ("constructor" === t) {
-        let t = void 0 !== e.data.cols ? e.data.cols : 9, i = void 0 !== e.data.rows ? e.data.rows : 9,
-                curr = void 0 !== e.data.BotLevel ? e.data.BotLevel : 1, l = new _(t, i, curr);
-        d[l.bot_id] = l, r = l.bot_id
-    } else {
-        var curr = e.data.gtp_id;
-        if (d[curr] !== undefined && d[curr] !== null) {
-            let l = d[curr];
-            switch (t) {
-                case "busy":
-                    r = l.busy();
-                    break;
-                case "set_bot_level": {
-                    let t = e.data.BotLevel;
-                    if (0 == t) {
-                        let i = e.data.params;
-                        r = l.set_bot_level(t, i.mcts_visits, i.ladder_depth, i.anti_ladder_depth, i.anti_ladder_nearest, i.minimax_depth, i.minimax_ladder, i.capture_prob, i.can_resign)
-                    } else r = l.set_bot_level(t)
-                }
-                    break;
-                case "request": {
-                    let t = e.data.request;
-                    r = l.request(t)
-                }
-                    break;
-                case "destructor":
-                    void 0 !== d[curr] && (l.destructor(), d[curr] = null);
-                    break;
-                default:
-                    r = null, i = "Unknown command"
-            }
-        } else r = null, i = "Not found GtpInterface (id:" + curr + ")"
-    }
-    postMessage({
-                        command: t, result: r, error: i
-                })
-}
-
- */
\ No newline at end of file
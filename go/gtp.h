@@ -0,0 +1,228 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include "go.h"
+
+// Go Text Protocol front-end for a single game between the engine and whoever is driving it.
+// Besides the standard commands it understands
+//   set_bot_level <1-6>                  JOKE to DEMON
+//   set_bot_level 0 <mcts_visits> <ladder_depth> <anti_ladder_depth> <anti_ladder_nearest> <minimax_depth>
+//                   <minimax_ladder> <capture_prob> <can_resign> [solver_empty_points] [minimax_shapes]
+//   search_stats [color]                 what the last genmove (by default) or color's last move spent its time on
+// where the custom settings follow the order of the old JS worker.
+class GtpEngine {
+    Board board;
+    Bot::Settings settings = Bot::level_settings(Bot::MEDIUM);
+    std::shared_ptr<const OpeningBook> book;
+    std::shared_ptr<const PatternTable> patterns = PatternTable::uniform();
+    std::unique_ptr<Bot> bots[2];
+    Color last_to_move = BLACK;
+    bool done = false;
+
+    static constexpr std::string_view columns = "ABCDEFGHJKLMNOPQRST";
+    static constexpr std::string_view commands[] = {
+            "protocol_version", "name", "version", "known_command", "list_commands", "quit", "boardsize",
+            "clear_board", "komi", "play", "genmove", "showboard", "set_bot_level",
+            "search_stats"
+    };
+
+public:
+    explicit GtpEngine(Bot::Settings settings = Bot::level_settings(Bot::MEDIUM)) : settings(settings) {
+        reset_bots();
+    }
+
+    // Kept across set_bot_level
+    void set_opening_book(std::shared_ptr<const OpeningBook> opening_book) {
+        book = std::move(opening_book);
+        reset_bots();
+    }
+
+    // Kept across set_bot_level
+    void set_patterns(std::shared_ptr<const PatternTable> table) {
+        patterns = std::move(table);
+        reset_bots();
+    }
+
+    [[nodiscard]] bool quit() const {
+        return done;
+    }
+
+    // Answers one line of input, or returns nothing for blank lines and comments
+    std::optional<std::string> handle(std::string_view line) {
+        std::string clean;
+        for (char c: line) {
+            if (c == '#') break;
+            if (c == '\t') c = ' ';
+            if (c >= 32 && c != 127) clean += c;
+        }
+        std::istringstream in(clean);
+        std::string id, command;
+        if (!(in >> command)) return std::nullopt;
+        if (std::ranges::all_of(command, [](unsigned char c) { return std::isdigit(c); })) {
+            id = command;
+            if (!(in >> command)) return std::nullopt;
+        }
+        std::vector<std::string> args;
+        for (std::string arg; in >> arg;) args.push_back(arg);
+
+        std::string result;
+        bool ok = true;
+        try {
+            result = run(command, args);
+        } catch (const std::runtime_error& e) {
+            ok = false;
+            result = e.what();
+        }
+        return (ok ? "=" : "?") + id + (result.empty() ? "" : " " + result) + "\n\n";
+    }
+
+    static std::string vertex_to_string(Move m) {
+        if (m.type() == Move::PASS) return "pass";
+        if (m.type() == Move::RESIGN) return "resign";
+        return std::string(1, columns[m.pos().col]) + std::to_string(size - m.pos().row);
+    }
+
+    static std::optional<Move> parse_vertex(Color color, std::string s) {
+        std::ranges::transform(s, s.begin(), [](unsigned char c) { return (char) std::toupper(c); });
+        if (s == "PASS") return Move::pass(color);
+        if (s.size() < 2) return std::nullopt;
+        auto col = columns.find(s[0]);
+        if (col == std::string_view::npos) return std::nullopt;
+        // The row is digits and nothing else, so that "A1X" is not taken for A1
+        if (!std::ranges::all_of(s.substr(1), [](unsigned char c) { return std::isdigit(c); })) return std::nullopt;
+        Pos p{size - parse_int(s.substr(1)), (int) col};
+        if (!Board::is_pos_valid(p)) return std::nullopt;
+        return Move::play_at(color, p);
+    }
+
+    // GTP numbering of the bot levels, 1 to 6 for JOKE to DEMON
+    static Bot::Settings parse_level(int level) {
+        if (level < 1 || level > 6) throw std::runtime_error("unknown level");
+        return Bot::level_settings((Bot::BotLevel) (level - 1));
+    }
+
+    static std::optional<Color> parse_color(std::string s) {
+        std::ranges::transform(s, s.begin(), [](unsigned char c) { return (char) std::tolower(c); });
+        if (s == "b" || s == "black") return BLACK;
+        if (s == "w" || s == "white") return WHITE;
+        return std::nullopt;
+    }
+
+    static int parse_int(const std::string& s) {
+        try {
+            return std::stoi(s);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("syntax error");
+        }
+    }
+
+private:
+    void reset_bots() {
+        bots[BLACK] = std::make_unique<Bot>(settings, BLACK, board);
+        bots[WHITE] = std::make_unique<Bot>(settings, WHITE, board);
+        for (auto& bot : bots) {
+            bot->set_opening_book(book);
+            bot->set_patterns(patterns);
+        }
+    }
+
+    // Returns the response to a command, or throws std::runtime_error with the failure message
+    std::string run(const std::string& command, const std::vector<std::string>& args) {
+        auto arg = [&](size_t i) -> const std::string& {
+            if (i >= args.size()) throw std::runtime_error("syntax error");
+            return args[i];
+        };
+        auto color_arg = [&](size_t i) {
+            auto color = parse_color(arg(i));
+            if (!color) throw std::runtime_error("syntax error");
+            return *color;
+        };
+
+        if (command == "protocol_version") return "2";
+        if (command == "name") return "atari_go_ai";
+        if (command == "version") return "1.0";
+        if (command == "known_command") return std::ranges::find(commands, arg(0)) != std::end(commands) ? "true" : "false";
+        if (command == "list_commands") {
+            std::string res;
+            for (auto c: commands) res += (res.empty() ? "" : "\n") + std::string(c);
+            return res;
+        }
+        if (command == "quit") {
+            done = true;
+            return "";
+        }
+        if (command == "boardsize") {
+            if (parse_int(arg(0)) != size) throw std::runtime_error("unacceptable size");
+            board.clear();
+            return "";
+        }
+        if (command == "clear_board") {
+            board.clear();
+            return "";
+        }
+        if (command == "komi") {
+            arg(0);
+            return "";
+        }
+        if (command == "play") {
+            Color color = color_arg(0);
+            auto move = parse_vertex(color, arg(1));
+            if (!move) throw std::runtime_error("syntax error");
+            if (!bots[color]->play(*move)) throw std::runtime_error("illegal move");
+            return "";
+        }
+        if (command == "genmove") {
+            Color color = color_arg(0);
+            Move move = bots[color]->get_move();
+            bots[color]->play(move);
+            last_to_move = color;
+            return vertex_to_string(move);
+        }
+        if (command == "showboard") return "\n" + board.to_string();
+        if (command == "set_bot_level") {
+            int level = parse_int(arg(0));
+            if (level == 0) {
+                Bot::Settings s;
+                s.mcts_visits = parse_int(arg(1));
+                s.ladder_depth = parse_int(arg(2));
+                s.anti_ladder_depth = parse_int(arg(3));
+                s.anti_ladder_nearest = parse_bool(arg(4));
+                s.minimax_depth = parse_int(arg(5));
+                s.minimax_ladder = parse_bool(arg(6));
+                s.capture_prob = parse_double(arg(7));
+                s.can_resign = parse_bool(arg(8));
+                if (args.size() > 9) s.solver_empty_points = parse_int(arg(9));
+                if (args.size() > 10) s.minimax_shapes = parse_bool(arg(10));
+                settings = s;
+            }
+            else settings = parse_level(level);
+            reset_bots();
+            return "";
+        }
+        if (command == "search_stats") {
+            if (!SearchStats::enabled) throw std::runtime_error("built without ATARI_GO_STATS");
+            return "\n" + bots[args.empty() ? last_to_move : color_arg(0)]->stats().to_string();
+        }
+        throw std::runtime_error("unknown command");
+    }
+
+    static double parse_double(const std::string& s) {
+        try {
+            return std::stod(s);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("syntax error");
+        }
+    }
+
+    static bool parse_bool(const std::string& s) {
+        return s == "1" || s == "true";
+    }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cerrno>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Writes everything to stdout, waiting for it to drain if it is non-blocking
+inline void write_all(std::string_view s) {
+    while (!s.empty()) {
+        ssize_t n = write(STDOUT_FILENO, s.data(), s.size());
+        if (n > 0) s.remove_prefix(n);
+        else if (n < 0 && errno != EAGAIN && errno != EINTR) return;
+        else {
+            pollfd out{STDOUT_FILENO, POLLOUT, 0};
+            poll(&out, 1, -1);
+        }
+    }
+}
+
+// Calls handle(line) for every line on stdin until it returns false or input ends. Stdin is read without
+// blocking, so whole buffers of pipelined commands are split into lines without waiting on a partial line. Its flags
+// are put back however this returns, as on a terminal they are shared with stdout and the shell.
+template<typename F>
+void read_lines(F handle) {
+    struct NonBlocking {
+        int flags = fcntl(STDIN_FILENO, F_GETFL);
+
+        NonBlocking() {
+            if (flags >= 0) fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+        }
+
+        ~NonBlocking() {
+            if (flags >= 0) fcntl(STDIN_FILENO, F_SETFL, flags);
+        }
+    } non_blocking;
+
+    std::string pending;
+    char buffer[4096];
+    while (true) {
+        pollfd in{STDIN_FILENO, POLLIN, 0};
+        if (poll(&in, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        bool eof = false;
+        while (true) {
+            ssize_t n = read(STDIN_FILENO, buffer, sizeof buffer);
+            if (n > 0) pending.append(buffer, n);
+            else if (n == 0) eof = true;
+            else if (errno == EINTR) continue;
+            break;
+        }
+        if (eof && !pending.empty() && pending.back() != '\n') pending += '\n';
+
+        size_t start = 0;
+        for (size_t end; (end = pending.find('\n', start)) != std::string::npos; start = end + 1) {
+            if (!handle(std::string_view(pending).substr(start, end - start))) return;
+        }
+        pending.erase(0, start);
+        if (eof) return;
+    }
+}
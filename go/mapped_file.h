@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only view of a whole file, mapped into memory so that large collections are paged in as they are read
+class MappedFile {
+    const char* data = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("cannot open " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) < 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        length = (size_t) st.st_size;
+        if (length > 0) {
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot map " + path);
+            }
+            // Files are read front to back
+            ::madvise(p, length, MADV_SEQUENTIAL);
+            data = (const char*) p;
+        }
+        ::close(fd);
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+            : data(std::exchange(other.data, nullptr)), length(std::exchange(other.length, 0)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        std::swap(data, other.data);
+        std::swap(length, other.length);
+        return *this;
+    }
+
+    ~MappedFile() {
+        if (data) ::munmap((void*) data, length);
+    }
+
+    [[nodiscard]] std::string_view view() const {
+        return {data, length};
+    }
+
+    [[nodiscard]] size_t size() const {
+        return length;
+    }
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "board.h"
+
+// Visits, wins and losses of every point, shared by all the threads playing out games for one search. A point's
+// three counts are packed into one 64-bit word, 21 bits each, so a result lands with a single atomic add and a read
+// never sees half of one. Each word has a cache line to itself, so threads updating different points never contend.
+// No count may pass max_count: there is no room to wrap, so one more would carry into the next count and corrupt it.
+class MoveStats {
+    static constexpr int bits = 21;
+    static constexpr uint64_t mask = (uint64_t(1) << bits) - 1;
+
+public:
+    struct Counts {
+        int visits, wins, losses;
+    };
+
+    // Most playouts a point can be added to between clears
+    static constexpr int max_count = (int) mask;
+
+private:
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> packed{0};
+    };
+    std::array<Slot, size * size> slots;
+
+public:
+    // One playout through `point` that was won, lost, or neither (a draw)
+    void add(int point, bool won, bool lost) {
+        uint64_t delta = uint64_t(1) << (2 * bits) | uint64_t(won) << bits | uint64_t(lost);
+        slots[point].packed.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Counts get(int point) const {
+        uint64_t packed = slots[point].packed.load(std::memory_order_relaxed);
+        return {(int) (packed >> (2 * bits) & mask), (int) (packed >> bits & mask), (int) (packed & mask)};
+    }
+
+    void clear() {
+        for (auto& slot : slots) slot.packed.store(0, std::memory_order_relaxed);
+    }
+};
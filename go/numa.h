@@ -0,0 +1,122 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// The machine's NUMA nodes and the CPUs on each that the process may run on (its affinity mask, as set by taskset or
+// a cpuset), read from sysfs. Nodes with none of those CPUs are left out. Anywhere that is missing, or off Linux, the
+// whole machine counts as one node.
+struct NumaTopology {
+    std::vector<std::vector<int>> node_cpus;
+
+    static const NumaTopology& get() {
+        static const NumaTopology res = detect();
+        return res;
+    }
+
+    [[nodiscard]] int num_nodes() const {
+        return (int) node_cpus.size();
+    }
+
+    // Every CPU, node by node, so that consecutive workers share a node
+    [[nodiscard]] std::vector<std::pair<int, int>> cpus_by_node() const {
+        std::vector<std::pair<int, int>> res;
+        for (int node = 0; node < num_nodes(); node++) for (int cpu : node_cpus[node]) res.emplace_back(node, cpu);
+        return res;
+    }
+
+    [[nodiscard]] int num_cpus() const {
+        return (int) cpus_by_node().size();
+    }
+
+    // The node of the CPU the calling thread is running on right now, which for a thread not bound to one CPU may
+    // change at any time; 0 if that is unknown
+    [[nodiscard]] int current_node() const {
+#ifdef __linux__
+        int cpu = sched_getcpu();
+        for (int node = 0; node < num_nodes(); node++) {
+            if (std::ranges::find(node_cpus[node], cpu) != node_cpus[node].end()) return node;
+        }
+#endif
+        return 0;
+    }
+
+    // Binds the calling thread to one CPU, returning false if the system would not
+    static bool pin_current_thread(int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0;
+#else
+        (void) cpu;
+        return false;
+#endif
+    }
+
+private:
+    // A sysfs cpulist such as "0-3,8-11"
+    static std::vector<int> parse_cpu_list(const std::string& list) {
+        std::vector<int> res;
+        std::istringstream in(list);
+        for (std::string range; std::getline(in, range, ',');) {
+            size_t dash = range.find('-');
+            try {
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; cpu++) res.push_back(cpu);
+            } catch (const std::exception&) {}
+        }
+        return res;
+    }
+
+    // The CPUs in the calling thread's affinity mask, or every CPU if that is unknown
+    static std::vector<int> allowed_cpus() {
+        std::vector<int> res;
+#ifdef __linux__
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof set, &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) if (CPU_ISSET(cpu, &set)) res.push_back(cpu);
+        }
+#endif
+        if (res.empty()) for (int cpu = 0; cpu < (int) std::max(std::thread::hardware_concurrency(), 1u); cpu++)
+            res.push_back(cpu);
+        return res;
+    }
+
+    static NumaTopology detect() {
+        NumaTopology res;
+        std::vector<int> allowed = allowed_cpus();
+        std::error_code error;
+        std::vector<std::string> nodes;
+        for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+            std::string name = entry.path().filename().string();
+            if (name.starts_with("node") && name.size() > 4 && std::isdigit((unsigned char) name[4]))
+                nodes.push_back(entry.path().string());
+        }
+        // Numerically, so that node10 comes after node2
+        std::ranges::sort(nodes, {}, [](const std::string& path) {
+            return std::stoi(path.substr(path.rfind("node") + 4));
+        });
+        for (const auto& node : nodes) {
+            std::ifstream in(node + "/cpulist");
+            std::string list;
+            std::getline(in, list);
+            auto cpus = parse_cpu_list(list);
+            std::erase_if(cpus, [&](int cpu) { return std::ranges::find(allowed, cpu) == allowed.end(); });
+            if (!cpus.empty()) res.node_cpus.push_back(std::move(cpus));
+        }
+        if (res.node_cpus.empty()) res.node_cpus.push_back(allowed);
+        return res;
+    }
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include "board.h"
+#include "game_record.h"
+#include "mapped_file.h"
+
+// Moves seen from early positions and how they turned out, looked up in a mapped file. Positions are keyed by
+// Board::canonical_hash() and moves stored in the canonical frame, so rotations and reflections share entries.
+//
+// Layout, in native (little-endian) byte order:
+//   header   "AGOB", uint32 version 2, uint64 number of entries
+//   entries  sorted by hash, each a uint64 hash, uint32 times played, uint32 times the player went on to win and the
+//            move as a packed 16-bit Move, padded to 24 bytes
+class OpeningBook {
+public:
+    struct Entry {
+        uint64_t hash;
+        uint32_t visits, wins;
+        Move move;
+        uint16_t unused[3]{};
+    };
+    static_assert(sizeof(Entry) == 24 && std::is_trivially_copyable_v<Entry>);
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t num_entries;
+    };
+
+private:
+    MappedFile file;
+    std::span<const Entry> entries;
+
+public:
+    explicit OpeningBook(const std::string& path) : file(path) {
+        std::string_view data = file.view();
+        Header header{};
+        if (data.size() < sizeof header) throw std::runtime_error("Not an opening book: " + path);
+        std::memcpy(&header, data.data(), sizeof header);
+        if (std::string_view(header.magic, 4) != "AGOB" || header.version != 2)
+            throw std::runtime_error("Not an opening book: " + path);
+        if ((data.size() - sizeof header) / sizeof(Entry) < header.num_entries)
+            throw std::runtime_error("Truncated opening book " + path);
+        entries = {reinterpret_cast<const Entry*>(data.data() + sizeof header), header.num_entries};
+    }
+
+    [[nodiscard]] size_t size() const {
+        return entries.size();
+    }
+
+    // Every move in the book from this position, in its canonical frame
+    [[nodiscard]] std::span<const Entry> find(const Board& board, Color to_move) const {
+        uint64_t hash = board.canonical_hash(to_move);
+        auto [first, last] = std::ranges::equal_range(entries, hash, {}, &Entry::hash);
+        return {first, last};
+    }
+
+    // The legal book move with the best win rate (counting one extra win and loss, so that a lucky move played once
+    // does not beat a good one played often), if the position is in the book
+    [[nodiscard]] std::optional<Move> best_move(const Board& board, Color to_move) const {
+        std::optional<Move> res;
+        double best = -1;
+        int back = inverse_symmetry(board.canonical_symmetry(to_move));
+        for (const Entry& e : find(board, to_move)) {
+            double rate = (e.wins + 1.) / (e.visits + 2.);
+            Move m = e.move.transform(back);
+            if (rate > best && m.color() == to_move && board.is_valid_move(to_move, m.pos())) {
+                best = rate;
+                res = m;
+            }
+        }
+        return res;
+    }
+};
+
+// Collects the first moves of many games into an opening book
+class OpeningBookBuilder {
+    std::map<std::pair<uint64_t, int>, std::pair<uint32_t, uint32_t>> stats; // (hash, point) -> (visits, wins)
+    int max_plies;
+
+public:
+    explicit OpeningBookBuilder(int max_plies) : max_plies(max_plies) {}
+
+    // Games without a winner teach us nothing
+    void add(const GameView& game) {
+        if (!game.winner) return;
+        Board board;
+        int ply = 0;
+        game.replay(board, [&](const Board& b, Move m) {
+            if (ply++ >= max_plies || m.type() != Move::PLACE) return;
+            Move canonical = canonical_move(b, m.color(), m);
+            auto& [visits, wins] = stats[{b.canonical_hash(m.color()), canonical.point() | m.color() << 10}];
+            visits++;
+            wins += *game.winner == m.color();
+        });
+    }
+
+    // Leaves out moves played fewer than min_visits times
+    void save(const std::string& path, uint32_t min_visits = 1) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) throw std::runtime_error("Cannot create opening book " + path);
+
+        std::vector<OpeningBook::Entry> entries;
+        for (auto& [key, value] : stats) if (value.first >= min_visits) {
+            Color color = (Color) (key.second >> 10);
+            int point = key.second & 0x3FF;
+            entries.push_back({key.first, value.first, value.second, Move::play_at(color, {point / ::size, point % ::size}), {}});
+        }
+        OpeningBook::Header header{{'A', 'G', 'O', 'B'}, 2, entries.size()};
+        out.write(reinterpret_cast<const char*>(&header), sizeof header);
+        out.write(reinterpret_cast<const char*>(entries.data()), (std::streamsize) (entries.size() * sizeof(OpeningBook::Entry)));
+        if (!out) throw std::runtime_error("Cannot write opening book " + path);
+    }
+
+    [[nodiscard]] size_t size() const {
+        return stats.size();
+    }
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+
+// Neighbourhoods are packed two bits per point, in the row-major order used by Pos::locality() and
+// Pos::locality2(): 0 = empty, 1 = black stone, 2 = white stone, 3 = off the board.
+
+constexpr int locality_size = 8, locality2_size = 24;
+
+// Swaps black and white stones in a packed 3x3 neighbourhood, leaving empty and off-board points alone
+constexpr uint16_t swap_locality_colors(uint16_t code) {
+    auto diff = (uint16_t) ((code ^ (code >> 1)) & 0x5555);
+    return code ^ (uint16_t) (diff | (diff << 1));
+}
+
+// Next number from a splitmix64 generator, for filling tables of Zobrist keys at compile time
+constexpr uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Zobrist keys for each point of a 5x5 neighbourhood and each non-empty state
+inline constexpr auto locality2_keys = [] {
+    std::array<std::array<uint64_t, 3>, locality2_size> res{};
+    uint64_t seed = 0;
+    for (auto &point: res) for (auto &key: point) key = splitmix64(seed);
+    return res;
+}();
+
+constexpr uint64_t hash_locality2(uint64_t pattern) {
+    uint64_t res = 0;
+    for (int i = 0; i < locality2_size; i++) {
+        int state = (int) (pattern >> (2 * i)) & 3;
+        if (state) res ^= locality2_keys[i][state - 1];
+    }
+    return res;
+}
+
+// For each of the 8 board symmetries, where each point of a (2 * radius + 1)^2 neighbourhood ends up
+template<int radius>
+inline constexpr auto locality_symmetries = [] {
+    constexpr int width = 2 * radius + 1, n = width * width - 1;
+    auto index = [](int dr, int dc) {
+        int i = (dr + radius) * width + (dc + radius);
+        return i > n / 2 ? i - 1 : i;
+    };
+    std::array<std::array<int, n>, 8> res{};
+    for (int s = 0; s < 8; s++) {
+        for (int dr = -radius; dr <= radius; dr++) for (int dc = -radius; dc <= radius; dc++) {
+            if (!dr && !dc) continue;
+            int r = dr, c = dc;
+            if (s & 4) std::swap(r, c);
+            if (s & 1) r = -r;
+            if (s & 2) c = -c;
+            res[s][index(dr, dc)] = index(r, c);
+        }
+    }
+    return res;
+}();
+
+template<int radius, typename T>
+constexpr T transform_locality(T pattern, int symmetry) {
+    T res = 0;
+    const auto &perm = locality_symmetries<radius>[symmetry];
+    for (int i = 0; i < (int) perm.size(); i++) res |= (T) ((pattern >> (2 * i)) & 3) << (2 * perm[i]);
+    return res;
+}
+
+// Weights for sampling playout moves by the shape around them, seen from the side to move (as black).
+//
+// On disk the table is little-endian:
+//   char magic[4] = "AGPT", uint32 version = 1, uint32 num_locality, uint32 num_locality2,
+//   num_locality  x { uint16 code;    uint16 weight }   3x3 patterns, weight replaces the default of 1
+//   num_locality2 x { uint64 pattern; uint16 weight }   5x5 patterns, weight multiplies the 3x3 one
+// with weights in 1/256ths. Only one orientation of each pattern needs to be stored.
+struct PatternTable {
+    std::vector<float> locality_weights = std::vector<float>(1 << 16, 1.f);
+    std::vector<std::pair<uint64_t, float>> locality2_weights; // Sorted by hash
+    std::vector<std::pair<uint64_t, float>> locality2_patterns; // As given to set_locality2_weights, for save()
+
+    // Shared table of all ones, so bots without learned weights do not each carry their own
+    static std::shared_ptr<const PatternTable> uniform() {
+        static const auto res = std::make_shared<const PatternTable>();
+        return res;
+    }
+
+    [[nodiscard]] float weight(uint16_t code, uint64_t hash) const {
+        float res = locality_weights[code];
+        if (!locality2_weights.empty()) {
+            auto it = std::ranges::lower_bound(locality2_weights, hash, {}, &std::pair<uint64_t, float>::first);
+            if (it != locality2_weights.end() && it->first == hash) res *= it->second;
+        }
+        return res;
+    }
+
+    void set_locality_weight(uint16_t code, float weight) {
+        for (int s = 0; s < 8; s++) locality_weights[transform_locality<1>(code, s)] = weight;
+    }
+
+    void set_locality2_weights(const std::vector<std::pair<uint64_t, float>> &patterns) {
+        locality2_patterns = patterns;
+        locality2_weights.clear();
+        for (auto [pattern, weight]: patterns) for (int s = 0; s < 8; s++)
+            locality2_weights.emplace_back(hash_locality2(transform_locality<2>(pattern, s)), weight);
+        std::ranges::sort(locality2_weights);
+        auto [first, last] = std::ranges::unique(locality2_weights, {}, &std::pair<uint64_t, float>::first);
+        locality2_weights.erase(first, last);
+    }
+
+    static PatternTable load(const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Cannot open pattern table " + path);
+
+        auto read = [&in, &path]<typename T>(T &value) {
+            if (!in.read(reinterpret_cast<char *>(&value), sizeof value))
+                throw std::runtime_error("Truncated pattern table " + path);
+        };
+
+        char magic[4];
+        uint32_t version, num_locality, num_locality2;
+        read(magic), read(version), read(num_locality), read(num_locality2);
+        if (std::string_view(magic, 4) != "AGPT" || version != 1)
+            throw std::runtime_error("Not a pattern table: " + path);
+
+        PatternTable res;
+        for (uint32_t i = 0; i < num_locality; i++) {
+            uint16_t code, weight;
+            read(code), read(weight);
+            res.set_locality_weight(code, weight / 256.f);
+        }
+        std::vector<std::pair<uint64_t, float>> patterns(num_locality2);
+        for (auto &[pattern, weight]: patterns) {
+            uint16_t w;
+            read(pattern), read(w);
+            weight = w / 256.f;
+        }
+        res.set_locality2_weights(patterns);
+        return res;
+    }
+
+    // Writes the table in the format load() reads, leaving out 3x3 weights of one
+    void save(const std::string &path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) throw std::runtime_error("Cannot create pattern table " + path);
+
+        auto write = [&out]<typename T>(const T &value) {
+            out.write(reinterpret_cast<const char *>(&value), sizeof value);
+        };
+        auto quantize = [](float weight) {
+            return (uint16_t) std::clamp(weight * 256.f + .5f, 1.f, 65535.f);
+        };
+
+        uint32_t num_locality = 0;
+        for (float w: locality_weights) num_locality += w != 1.f;
+        out.write("AGPT", 4);
+        write((uint32_t) 1), write(num_locality), write((uint32_t) locality2_patterns.size());
+        for (uint32_t code = 0; code < locality_weights.size(); code++) if (locality_weights[code] != 1.f)
+            write((uint16_t) code), write(quantize(locality_weights[code]));
+        for (auto [pattern, weight]: locality2_patterns) write(pattern), write(quantize(weight));
+        if (!out) throw std::runtime_error("Cannot write pattern table " + path);
+    }
+};
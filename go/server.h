@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include "gtp.h"
+#include "thread_pool.h"
+
+// Hosts many independent games in one process, each a GtpEngine keyed by its gtp_id as in the old JS worker,
+// with every game's requests run on one shared pool of threads. Input lines are
+//   constructor [level]          -> "= <gtp_id>"
+//   destructor <gtp_id>          -> "="
+//   busy <gtp_id>                -> "= true" or "= false", whether the game still has requests to answer
+//   request <gtp_id> <gtp line>  -> nothing until a worker gets to it, then "@<gtp_id> " and the GTP response
+// and every reply ends with a blank line as in GTP. Requests to one game are answered in order.
+class BotServer {
+    struct Session {
+        const int id;
+        GtpEngine engine;
+        std::mutex mutex;
+        std::deque<std::string> requests;
+        bool scheduled = false, closed = false;
+        std::atomic<bool> busy = false;
+
+        Session(int id, Bot::Settings settings) : id(id), engine(settings) {}
+    };
+
+    // Called from the workers as well as the thread calling handle(), so it has to be thread safe
+    const std::function<void(const std::string&)> output;
+    std::unordered_map<int, std::shared_ptr<Session>> sessions;
+    std::shared_ptr<const PatternTable> patterns = PatternTable::uniform();
+    int next_id = 0;
+    ThreadPool pool; // Last, so that it finishes its tasks before anything else goes away
+
+public:
+    BotServer(std::function<void(const std::string&)> output, unsigned num_threads = std::thread::hardware_concurrency())
+            : output(std::move(output)), pool(num_threads) {}
+
+    // For the games constructed from now on
+    void set_patterns(std::shared_ptr<const PatternTable> table) {
+        patterns = std::move(table);
+    }
+
+    [[nodiscard]] size_t count() const {
+        return sessions.size();
+    }
+
+    // Handles one line of input; never waits on a bot
+    void handle(std::string_view line) {
+        std::istringstream in{std::string(line)};
+        std::string command;
+        if (!(in >> command)) return;
+
+        try {
+            if (command == "constructor") {
+                int level = 1;
+                if (std::string arg; in >> arg) level = GtpEngine::parse_int(arg);
+                int id = next_id++;
+                auto session = sessions[id] = std::make_shared<Session>(id, GtpEngine::parse_level(level));
+                session->engine.set_patterns(patterns);
+                return output("= " + std::to_string(id) + "\n\n");
+            }
+
+            std::string id_arg;
+            if (!(in >> id_arg)) throw std::runtime_error("syntax error");
+            auto it = sessions.find(GtpEngine::parse_int(id_arg));
+            if (it == sessions.end()) throw std::runtime_error("Not found GtpInterface (id:" + id_arg + ")");
+            auto session = it->second;
+
+            if (command == "busy") output(session->busy ? "= true\n\n" : "= false\n\n");
+            else if (command == "destructor") {
+                {
+                    std::lock_guard lock(session->mutex);
+                    session->closed = true;
+                    session->requests.clear();
+                }
+                sessions.erase(it);
+                output("=\n\n");
+            }
+            else if (command == "request") {
+                std::string request;
+                std::getline(in, request);
+                std::lock_guard lock(session->mutex);
+                session->requests.push_back(std::move(request));
+                session->busy = true;
+                if (!session->scheduled) {
+                    session->scheduled = true;
+                    pool.submit([this, session] { answer(session); }, true);
+                }
+            }
+            else throw std::runtime_error("Unknown command");
+        } catch (const std::runtime_error& e) {
+            output("? " + std::string(e.what()) + "\n\n");
+        }
+    }
+
+private:
+    // Answers one request, then goes to the back of the queue if the game has more, so that one busy game
+    // cannot hold a worker while thousands of others wait
+    void answer(const std::shared_ptr<Session>& session) {
+        std::string request;
+        {
+            std::lock_guard lock(session->mutex);
+            if (session->closed || session->requests.empty()) {
+                session->scheduled = session->busy = false;
+                return;
+            }
+            request = std::move(session->requests.front());
+            session->requests.pop_front();
+        }
+
+        auto response = session->engine.handle(request);
+
+        // Under the lock, so that nothing is written for a game once its destructor has been answered
+        std::lock_guard lock(session->mutex);
+        if (response && !session->closed) output("@" + std::to_string(session->id) + " " + *response);
+        if (session->closed || session->requests.empty()) session->scheduled = session->busy = false;
+        else pool.submit([this, session] { answer(session); }, true);
+    }
+};
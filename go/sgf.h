@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <optional>
+#include <cctype>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include "go.h"
+#include "game_record.h"
+
+// Reads the games of an SGF collection one at a time straight out of a buffer (usually a MappedFile), keeping only
+// what replays need: the setup stones, the main line of moves and the result. Games on other board sizes, including
+// those without SZ (19 by SGF's default), are skipped and counted. Malformed input throws std::runtime_error.
+class SgfReader {
+    std::string_view text;
+    size_t at = 0;
+    long num_skipped = 0;
+
+public:
+    explicit SgfReader(std::string_view text) : text(text) {}
+
+    // Reads the next game on our board into `game`, or returns false at the end of the collection
+    bool next(GameRecord& game) {
+        while (true) {
+            game.clear();
+            at = std::min(text.find('(', at), text.size());
+            if (at == text.size()) return false;
+            if (read_game(game)) return true;
+            num_skipped++;
+        }
+    }
+
+    [[nodiscard]] long skipped() const {
+        return num_skipped;
+    }
+
+    // Byte offset reached, for progress reports and error messages
+    [[nodiscard]] size_t offset() const {
+        return at;
+    }
+
+private:
+    // Reads one game tree starting at its '('. The main line is every node before the first ')', since it always
+    // takes the first variation; the rest of the tree is skipped. The root node's properties wait until it ends, as
+    // setup stones may come before SZ.
+    bool read_game(GameRecord& game) {
+        int depth = 0, board_size = 19, nodes = 0;
+        bool main_line = true;
+        std::string_view key;
+        std::vector<std::pair<std::string_view, std::string_view>> root;
+        auto end_root = [&] {
+            if (board_size == size) for (auto [k, v] : root) property(game, k, v);
+            root.clear();
+        };
+        while (at < text.size()) {
+            char c = text[at];
+            if (c == '[') {
+                size_t end = value_end(at + 1);
+                if (main_line) {
+                    std::string_view value = text.substr(at + 1, end - at - 1);
+                    if (key == "SZ") board_size = parse_size(value);
+                    else if (nodes <= 1) root.emplace_back(key, value);
+                    else if (board_size == size) property(game, key, value);
+                }
+                at = end + 1;
+                continue;
+            }
+            at++;
+            if (c == ';' && ++nodes == 2) end_root();
+            else if (c == '(') depth++;
+            else if (c == ')') {
+                if (main_line) end_root();
+                main_line = false;
+                if (--depth == 0) return board_size == size;
+            }
+            else if (c >= 'A' && c <= 'Z') {
+                // Property names are runs of capitals, though FF[3] also allowed lower case letters in between
+                size_t start = at - 1;
+                while (at < text.size() && std::isalpha((unsigned char) text[at])) at++;
+                key = text.substr(start, at - start);
+            }
+        }
+        throw std::runtime_error("sgf: unterminated game tree");
+    }
+
+    // Index of the ']' closing a value that starts at `from`, skipping escaped characters
+    size_t value_end(size_t from) const {
+        for (size_t i = from; i < text.size(); i++) {
+            if (text[i] == '\\') i++;
+            else if (text[i] == ']') return i;
+        }
+        throw std::runtime_error("sgf: unterminated property value");
+    }
+
+    static void property(GameRecord& game, std::string_view key, std::string_view value) {
+        if (key == "B" || key == "W") {
+            Color color = key == "B" ? BLACK : WHITE;
+            auto p = parse_point(value);
+            game.moves.push_back(p ? Move::play_at(color, *p) : Move::pass(color));
+        }
+        else if (key == "AB" || key == "AW") {
+            Color color = key == "AB" ? BLACK : WHITE;
+            // FF[4] allows compressed rectangles "aa:cc"
+            auto colon = value.find(':');
+            auto from = parse_point(value.substr(0, colon));
+            auto to = colon == std::string_view::npos ? from : parse_point(value.substr(colon + 1));
+            if (!from || !to) throw std::runtime_error("sgf: bad setup point");
+            for (int row = from->row; row <= to->row; row++) for (int col = from->col; col <= to->col; col++)
+                game.setup.push_back(Move::play_at(color, {row, col}));
+        }
+        else if (key == "RE" && !value.empty()) {
+            if (value[0] == 'B') game.winner = BLACK;
+            else if (value[0] == 'W') game.winner = WHITE;
+        }
+    }
+
+    static int parse_size(std::string_view value) {
+        int n = 0;
+        for (char c : value) {
+            if (c == ':') break; // Rectangular boards never match ours
+            if (c < '0' || c > '9') throw std::runtime_error("sgf: bad board size");
+            n = n * 10 + (c - '0');
+        }
+        return n;
+    }
+
+    // Column then row, 'a' being the top left. An empty value (or "tt" in FF[3]) is a pass.
+    static std::optional<Pos> parse_point(std::string_view value) {
+        if (value.empty() || value == "tt") return std::nullopt;
+        if (value.size() != 2) throw std::runtime_error("sgf: bad point");
+        Pos p{value[1] - 'a', value[0] - 'a'};
+        if (!Board::is_pos_valid(p)) throw std::runtime_error("sgf: point off the board");
+        return p;
+    }
+};
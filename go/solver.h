@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <cstdint>
+#include "board.h"
+#include "stats.h"
+
+// Exact depth-first solver for atari go positions with few empty points left. Whoever captures first wins; a
+// player with no legal move passes, and two passes in a row is a draw. Positions are cached in a transposition
+// table keyed by Board::canonical_hash(), so rotations and reflections are solved once, and the table is kept
+// between calls since the same endgame is usually searched again a move later.
+class EndgameSolver {
+public:
+    enum Result : int8_t { LOSS = -1, DRAW = 0, WIN = 1 }; // For the side to move
+
+private:
+    enum Bound : uint8_t { EMPTY, EXACT, LOWER, UPPER };
+
+    struct Entry {
+        uint64_t key;
+        int8_t value;
+        Bound bound;
+    };
+
+    std::vector<Entry> table;
+    long nodes = 0, max_nodes;
+    SearchStats* stats;
+
+    static constexpr uint64_t passed_key = 0x6A09E667F3BCC909ull;
+
+public:
+    // Solving gives up after visiting max_nodes positions, until reset_budget(). The table holds 2^table_bits
+    // entries.
+    explicit EndgameSolver(long max_nodes = 200000, int table_bits = 16, SearchStats* stats = nullptr)
+            : table(size_t(1) << table_bits), max_nodes(max_nodes), stats(stats) {}
+
+    void reset_budget() {
+        nodes = 0;
+    }
+
+    // Result of playing `m` for its player, or nothing if the position was too big to solve
+    std::optional<Result> solve_move(const Board& board, Move m) {
+        Color color = m.color();
+        if (board.is_capture(color, m.pos())) return WIN;
+        Board next = board.copy();
+        if (!next.place_stone(color, m.pos())) return std::nullopt;
+        auto res = search(next, ~color, LOSS, WIN, false);
+        if (!res) return std::nullopt;
+        return (Result) -*res;
+    }
+
+    // Result for the side to move, or nothing if the position was too big to solve
+    std::optional<Result> solve(const Board& board, Color to_move) {
+        auto res = search(board, to_move, LOSS, WIN, false);
+        if (!res) return std::nullopt;
+        return (Result) *res;
+    }
+
+private:
+    // Negamax with alpha-beta over {-1, 0, 1}. Returns nothing once the node budget runs out.
+    std::optional<int> search(const Board& board, Color color, int alpha, int beta, bool passed) {
+        if (++nodes > max_nodes) return std::nullopt;
+        if (stats) stats->count(SearchStats::NODES);
+
+        // Taking the last liberty of anything wins, and a capture is never suicide
+        for (const Group& g : board.activeGroups) if (g->color != color && g->numLiberties() == 1) return WIN;
+
+        uint64_t key = board.canonical_hash(color) ^ (passed ? passed_key : 0);
+        Entry& entry = table[key & (table.size() - 1)];
+        if (stats) stats->count(SearchStats::TT_PROBES);
+        if (entry.bound != EMPTY && entry.key == key) {
+            if (stats) stats->count(SearchStats::TT_HITS);
+            if (entry.bound == EXACT) return entry.value;
+            if (entry.bound == LOWER) alpha = std::max(alpha, (int) entry.value);
+            else beta = std::min(beta, (int) entry.value);
+            if (alpha >= beta) return entry.value;
+        }
+
+        int original_alpha = alpha, best = LOSS - 1;
+        bool moved = false;
+        for (int row = 0; row < size && best < beta; row++) for (int col = 0; col < size && best < beta; col++) {
+            Pos p{row, col};
+            if (!board.is_valid_move(color, p)) continue;
+            moved = true;
+            Board next = board.copy();
+            next.place_stone(color, p);
+            // Leaving anything in atari hands the enemy a capture
+            bool loses = std::ranges::any_of(next.activeGroups, [color](const Group& g) {
+                return g->color == color && g->numLiberties() == 1;
+            });
+            int value = LOSS;
+            if (!loses) {
+                auto res = search(next, ~color, -beta, -std::max(alpha, best), false);
+                if (!res) return std::nullopt;
+                value = -*res;
+            }
+            best = std::max(best, value);
+        }
+        if (!moved) {
+            if (passed) best = DRAW;
+            else {
+                auto res = search(board, ~color, -beta, -alpha, true);
+                if (!res) return std::nullopt;
+                best = -*res;
+            }
+        }
+
+        entry = {key, (int8_t) best, best <= original_alpha ? UPPER : best >= beta ? LOWER : EXACT};
+        return best;
+    }
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include <iomanip>
+
+// Build with -DATARI_GO_STATS=1 (the ATARI_GO_STATS CMake option) to collect search statistics. Without it every
+// counter and timer below compiles away.
+#ifndef ATARI_GO_STATS
+#define ATARI_GO_STATS 0
+#endif
+
+// What one get_move spent its time on. Counters are bumped from every thread helping with the search.
+class SearchStats {
+public:
+    static constexpr bool enabled = ATARI_GO_STATS;
+
+    enum Phase { CAPTURE, SOLVER, ANTI_CAPTURE, LADDER, ANTI_LADDER, MINIMAX, MCTS, NUM_PHASES };
+    static constexpr const char* phase_names[NUM_PHASES] = {
+            "capture", "solver", "anti_capture", "ladder", "anti_ladder", "minimax", "mcts"
+    };
+
+    enum Counter { NODES, PLAYOUTS, PLAYOUT_MOVES, BOARD_COPIES, TT_PROBES, TT_HITS, NUM_COUNTERS };
+    static constexpr const char* counter_names[NUM_COUNTERS] = {
+            "nodes", "playouts", "playout_moves", "board_copies", "tt_probes", "tt_hits"
+    };
+
+private:
+    std::atomic<long> calls[NUM_PHASES]{}, nanos[NUM_PHASES]{}, counters[NUM_COUNTERS]{};
+
+public:
+    // Times a phase from construction to destruction
+    class Timer {
+        SearchStats* stats = nullptr;
+        Phase phase{};
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        Timer(SearchStats& stats, Phase phase) {
+            if constexpr (enabled) {
+                this->stats = &stats;
+                this->phase = phase;
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        Timer(const Timer&) = delete;
+
+        ~Timer() {
+            if constexpr (enabled) {
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                stats->calls[phase].fetch_add(1, std::memory_order_relaxed);
+                stats->nanos[phase].fetch_add(std::chrono::nanoseconds(elapsed).count(), std::memory_order_relaxed);
+            }
+        }
+    };
+
+    void count(Counter counter, long n = 1) {
+        if constexpr (enabled) counters[counter].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& c : calls) c.store(0, std::memory_order_relaxed);
+        for (auto& c : nanos) c.store(0, std::memory_order_relaxed);
+        for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] long phase_calls(Phase phase) const {
+        return calls[phase].load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] double phase_seconds(Phase phase) const {
+        return (double) nanos[phase].load(std::memory_order_relaxed) * 1e-9;
+    }
+
+    [[nodiscard]] long get(Counter counter) const {
+        return counters[counter].load(std::memory_order_relaxed);
+    }
+
+    // Nodes are the positions read by the solver, ladder and minimax searches, playouts the random games of monte
+    // carlo
+    [[nodiscard]] double nodes_per_second() const {
+        return rate(get(NODES), phase_seconds(SOLVER) + phase_seconds(LADDER) + phase_seconds(ANTI_LADDER) +
+                                phase_seconds(MINIMAX));
+    }
+
+    [[nodiscard]] double playouts_per_second() const {
+        return rate(get(PLAYOUTS), phase_seconds(MCTS));
+    }
+
+    // Moves played in a random game before it was decided, the candidate itself included
+    [[nodiscard]] double moves_per_playout() const {
+        return get(PLAYOUTS) ? (double) get(PLAYOUT_MOVES) / (double) get(PLAYOUTS) : 0;
+    }
+
+    [[nodiscard]] double tt_hit_rate() const {
+        return get(TT_PROBES) ? (double) get(TT_HITS) / (double) get(TT_PROBES) : 0;
+    }
+
+    // One "name value" pair per line
+    [[nodiscard]] std::string to_string() const {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(6);
+        for (int p = 0; p < NUM_PHASES; p++) {
+            out << phase_names[p] << "_calls " << phase_calls((Phase) p) << "\n"
+                << phase_names[p] << "_seconds " << phase_seconds((Phase) p) << "\n";
+        }
+        for (int c = 0; c < NUM_COUNTERS; c++) out << counter_names[c] << " " << get((Counter) c) << "\n";
+        out << std::setprecision(2) << "nodes_per_second " << nodes_per_second() << "\n"
+            << "playouts_per_second " << playouts_per_second() << "\n"
+            << "moves_per_playout " << moves_per_playout() << "\n"
+            << std::setprecision(4) << "tt_hit_rate " << tt_hit_rate();
+        return out.str();
+    }
+
+private:
+    static double rate(long n, double seconds) {
+        return seconds > 0 ? (double) n / seconds : 0;
+    }
+};
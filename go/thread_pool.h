@@ -0,0 +1,250 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include "numa.h"
+
+// Work-stealing pool of worker threads. Each worker keeps its own deque of tasks, pushing and popping at the
+// bottom without locks while idle workers steal from the top (Chase-Lev). Tasks submitted from outside the
+// pool go through a shared queue. Searches fork work with a TaskGroup, whose wait() runs or steals tasks from the
+// deques and sleeps only when there are none, so nested parallelism never needs more threads than cores. A pinned
+// pool binds each worker to a core of its own, filling one NUMA node before the next, so that what a worker
+// allocates stays on its node.
+class ThreadPool {
+    typedef std::function<void()> Task;
+
+    // Fixed-size Chase-Lev deque; push() fails when full and the caller runs the task itself
+    class WorkDeque {
+        static constexpr int64_t capacity = 1 << 12;
+        std::unique_ptr<std::atomic<Task*>[]> buffer{new std::atomic<Task*>[capacity]};
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+
+    public:
+        // Owner only
+        bool push(Task* task) {
+            int64_t b = bottom.load(std::memory_order_relaxed), t = top.load(std::memory_order_acquire);
+            if (b - t >= capacity) return false;
+            buffer[b & (capacity - 1)].store(task, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Owner only
+        Task* pop() {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_seq_cst);
+            if (t > b) {
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            Task* task = buffer[b & (capacity - 1)].load(std::memory_order_relaxed);
+            if (t == b) {
+                // Last one left, race the thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    task = nullptr;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return task;
+        }
+
+        // Any thread
+        Task* steal() {
+            int64_t t = top.load(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_seq_cst);
+            if (t >= b) return nullptr;
+            Task* task = buffer[t & (capacity - 1)].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return task;
+        }
+    };
+
+    std::vector<std::unique_ptr<WorkDeque>> deques;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<Task*> injected; // Tasks from threads outside the pool, guarded by mutex
+    std::atomic<long> queued{0}, sleeping{0};
+    bool stopping = false;
+
+    // Which pool and deque the current thread works for, if any, and the NUMA node it is pinned to
+    static inline thread_local ThreadPool* current_pool = nullptr;
+    static inline thread_local int current_index = -1;
+    static inline thread_local int pinned_node = -1;
+
+public:
+    explicit ThreadPool(unsigned num_threads = std::thread::hardware_concurrency(), bool pinned = false) {
+        num_threads = std::max(num_threads, 1u);
+        auto cpus = NumaTopology::get().cpus_by_node();
+        for (unsigned i = 0; i < num_threads; i++) deques.push_back(std::make_unique<WorkDeque>());
+        for (unsigned i = 0; i < num_threads; i++) workers.emplace_back([this, i, pinned, cpus] {
+            if (pinned) {
+                auto [node, cpu] = cpus[i % cpus.size()];
+                if (NumaTopology::pin_current_thread(cpu)) pinned_node = node;
+            }
+            work((int) i);
+        });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Finishes the tasks already submitted before returning
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        available.notify_all();
+        for (auto& t: workers) t.join();
+    }
+
+    // Process-wide pool for bot searches
+    static ThreadPool& shared() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Process-wide pool with a worker pinned to every core the process may use
+    static ThreadPool& pinned() {
+        static ThreadPool pool(NumaTopology::get().num_cpus(), true);
+        return pool;
+    }
+
+    // The pool the calling thread works for, or the shared one if it is not a worker
+    static ThreadPool& current() {
+        return current_pool ? *current_pool : shared();
+    }
+
+    // The NUMA node of the calling thread: the one it is pinned to if it is a pinned worker, otherwise the node it
+    // happens to be running on, such as for a synchronous get_move from GTP or a thread outside the pool
+    static int current_node() {
+        return pinned_node >= 0 ? pinned_node : NumaTopology::get().current_node();
+    }
+
+    // A `job` is work of its own rather than part of a search, such as a whole move or another game's request. It
+    // always goes through the shared queue, even from a worker, so that no TaskGroup::wait picks it up.
+    void submit(Task task, bool job = false) {
+        auto* t = new Task(std::move(task));
+        if (current_pool == this && !job) {
+            if (!deques[current_index]->push(t)) {
+                // Our deque is full; doing it now is as good as anywhere
+                run(t);
+                return;
+            }
+        }
+        else {
+            std::lock_guard lock(mutex);
+            injected.push_back(t);
+        }
+        queued.fetch_add(1);
+        if (sleeping.load() > 0) {
+            { std::lock_guard lock(mutex); }
+            available.notify_one();
+        }
+    }
+
+    [[nodiscard]] size_t size() const {
+        return workers.size();
+    }
+
+    // Tasks that can be waited on together. The waiting thread runs tasks from its own deque or steals from the
+    // others until its own are done, but leaves the shared queue alone: the jobs in there are unrelated work, such as
+    // a whole game, that could hold up the wait for long and nest without limit.
+    class TaskGroup {
+        ThreadPool& pool;
+        std::atomic<long> pending{0};
+
+    public:
+        explicit TaskGroup(ThreadPool& pool = current()) : pool(pool) {}
+
+        TaskGroup(const TaskGroup&) = delete;
+
+        ~TaskGroup() {
+            wait();
+        }
+
+        template<typename F>
+        void run(F f) {
+            pending.fetch_add(1, std::memory_order_relaxed);
+            pool.submit([this, f = std::move(f)]() mutable {
+                f();
+                pending.fetch_sub(1, std::memory_order_release);
+                pending.notify_all();
+            });
+        }
+
+        // Sleeps rather than spins when there is nothing to steal, which is always the case for a thread outside the
+        // pool once the workers have taken its tasks from the shared queue, until one of ours finishes
+        void wait() {
+            for (long n; (n = pending.load(std::memory_order_acquire)) > 0;) {
+                if (!pool.run_one(false)) pending.wait(n, std::memory_order_acquire);
+            }
+        }
+    };
+
+    // Calls f(i) for every i in [begin, end) across the pool and waits for them all
+    template<typename F>
+    void parallel_for(int begin, int end, F f) {
+        TaskGroup group(*this);
+        for (int i = begin; i < end; i++) group.run([&f, i] { f(i); });
+        group.wait();
+    }
+
+private:
+    // Runs one task from anywhere in the pool, or only from the deques, if there is one
+    bool run_one(bool include_injected = true) {
+        Task* task = find_task(include_injected);
+        if (!task) return false;
+        run(task);
+        return true;
+    }
+
+    static void run(Task* task) {
+        (*task)();
+        delete task;
+    }
+
+    Task* find_task(bool include_injected) {
+        Task* task = nullptr;
+        if (current_pool == this) task = deques[current_index]->pop();
+        if (!task) {
+            // Steal, starting from the next deque along so that thieves spread out
+            int n = (int) deques.size(), start = current_pool == this ? current_index + 1 : 0;
+            for (int i = 0; i < n && !task; i++) task = deques[(start + i) % n]->steal();
+        }
+        if (!task && include_injected) {
+            std::lock_guard lock(mutex);
+            if (!injected.empty()) {
+                task = injected.front();
+                injected.pop_front();
+            }
+        }
+        if (task) queued.fetch_sub(1);
+        return task;
+    }
+
+    void work(int index) {
+        current_pool = this;
+        current_index = index;
+        while (true) {
+            if (run_one()) continue;
+
+            std::unique_lock lock(mutex);
+            sleeping.fetch_add(1);
+            available.wait(lock, [this] { return stopping || queued.load() > 0; });
+            sleeping.fetch_sub(1);
+            if (stopping && queued.load() == 0) return;
+        }
+    }
+};
@@ -1,7 +1,26 @@
 #include <iostream>
+#include <cstring>
 #include "go/go.h"
+#include "go/gtp.h"
+#include "go/line_io.h"
 
-int main() {
-    std::cout << "Hello, World!" << std::endl;
+// GTP engine on stdin/stdout, optionally given an opening book file and a pattern table from go_db train
+//   atari_go_ai [book.agob] [-t patterns.agpt]
+int main(int argc, char** argv) {
+    GtpEngine engine;
+    try {
+        for (int i = 1; i < argc; i++) {
+            if (!std::strcmp(argv[i], "-t") && i + 1 < argc)
+                engine.set_patterns(std::make_shared<const PatternTable>(PatternTable::load(argv[++i])));
+            else engine.set_opening_book(std::make_shared<const OpeningBook>(argv[i]));
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    read_lines([&](std::string_view line) {
+        if (auto response = engine.handle(line)) write_all(*response);
+        return !engine.quit();
+    });
     return 0;
 }
@@ -0,0 +1,34 @@
+#include <iostream>
+#include <mutex>
+#include <cstring>
+#include "go/server.h"
+#include "go/line_io.h"
+
+// Multi-game bot server on stdin/stdout, see BotServer for the protocol. Every game's bots use the pattern table
+// given with -t, from go_db train, if any.
+//   atari_go_server [-t patterns.agpt]
+int main(int argc, char** argv) {
+    std::mutex output_mutex;
+    BotServer server([&](const std::string& s) {
+        std::lock_guard lock(output_mutex);
+        write_all(s);
+    });
+    if (argc == 3 && !std::strcmp(argv[1], "-t")) {
+        try {
+            server.set_patterns(std::make_shared<const PatternTable>(PatternTable::load(argv[2])));
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    else if (argc != 1) {
+        std::cerr << "Usage: atari_go_server [-t patterns.agpt]" << std::endl;
+        return 1;
+    }
+    read_lines([&](std::string_view line) {
+        if (line == "quit") return false;
+        server.handle(line);
+        return true;
+    });
+    return 0;
+}
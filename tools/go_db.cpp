@@ -0,0 +1,133 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "../go/go.h"
+#include "../go/sgf.h"
+#include "../go/game_db.h"
+#include "../go/mapped_file.h"
+#include "../go/opening_book.h"
+
+// Builds and analyses game databases.
+//
+// Usage:
+//   go_db convert <out.agd> <in.sgf>...         packs SGF collections into a database
+//   go_db info <db.agd>                         counts games, moves and results
+//   go_db train <db.agd> <out.agpt> [min count] learns 3x3 pattern weights for PatternTable::load from the moves
+//                                               played, leaving patterns seen fewer than min count times (10) at one
+//   go_db book <db.agd> <out.agob> [plies] [min count]
+//                                               builds an opening book from the first plies (10) of every game, keeping
+//                                               moves played at least min count times (2)
+
+static int usage() {
+    std::cerr << "Usage: go_db convert <out.agd> <in.sgf>...\n"
+                 "       go_db info <db.agd>\n"
+                 "       go_db train <db.agd> <out.agpt> [min count]\n"
+                 "       go_db book <db.agd> <out.agob> [plies] [min count]" << std::endl;
+    return 1;
+}
+
+static int convert(const std::string& out, const std::vector<std::string>& in) {
+    GameDbWriter writer(out);
+    GameRecord game;
+    long skipped = 0;
+    for (const auto& file : in) {
+        MappedFile mapped(file);
+        SgfReader reader(mapped.view());
+        try {
+            while (reader.next(game)) writer.add(game.view());
+        } catch (const std::runtime_error& e) {
+            std::cerr << file << " at byte " << reader.offset() << ": " << e.what() << std::endl;
+            return 1;
+        }
+        skipped += reader.skipped();
+    }
+    writer.close();
+    std::cout << writer.size() << " games written, " << skipped << " skipped (not " << size << "x" << size << ")"
+              << std::endl;
+    return 0;
+}
+
+static int info(const std::string& path) {
+    GameDb db(path);
+    long moves = 0, wins[2] = {}, unknown = 0;
+    for (GameView game : db) {
+        moves += (long) game.moves.size();
+        if (game.winner) wins[*game.winner]++;
+        else unknown++;
+    }
+    std::cout << db.size() << " games  " << moves << " moves  black won " << wins[BLACK] << "  white won "
+              << wins[WHITE] << "  unknown " << unknown << std::endl;
+    return 0;
+}
+
+// The weight of a pattern is how much likelier it is to be played than a point picked at random, with the counts of
+// all 8 symmetries pooled together
+static int train(const std::string& path, const std::string& out, long min_count) {
+    GameDb db(path);
+    auto canonical = [](uint16_t code) {
+        uint16_t res = code;
+        for (int s = 1; s < 8; s++) res = std::min(res, transform_locality<1>(code, s));
+        return res;
+    };
+
+    std::vector<long> played(1 << 16), available(1 << 16);
+    long total_played = 0, total_available = 0;
+    Board board;
+    for (GameView game : db) {
+        board.clear();
+        game.replay(board, [&](const Board& b, Move m) {
+            if (m.type() != Move::PLACE) return;
+            for (int row = 0; row < size; row++) for (int col = 0; col < size; col++) {
+                if (!b.is_valid_move(m.color(), {row, col})) continue;
+                available[canonical(b.locality_code({row, col}, m.color()))]++;
+                total_available++;
+            }
+            played[canonical(b.locality_code(m.pos(), m.color()))]++;
+            total_played++;
+        });
+    }
+    if (!total_played) {
+        std::cerr << "No moves to learn from" << std::endl;
+        return 1;
+    }
+
+    PatternTable table;
+    double base = (double) total_played / (double) total_available;
+    int learned = 0;
+    for (int code = 0; code < 1 << 16; code++) if (available[code] >= min_count) {
+        double w = (double) (played[code] + 1) / (double) (available[code] + 1) / base;
+        table.set_locality_weight((uint16_t) code, (float) std::clamp(w, 1 / 256., 255.));
+        learned++;
+    }
+    table.save(out);
+    std::cout << learned << " patterns learned from " << total_played << " moves" << std::endl;
+    return 0;
+}
+
+static int book(const std::string& path, const std::string& out, int plies, long min_count) {
+    GameDb db(path);
+    OpeningBookBuilder builder(plies);
+    for (GameView game : db) builder.add(game);
+    builder.save(out, (uint32_t) min_count);
+    std::cout << OpeningBook(out).size() << " of " << builder.size() << " position moves kept" << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    try {
+        if (args.size() >= 3 && args[0] == "convert") return convert(args[1], {args.begin() + 2, args.end()});
+        if (args.size() == 2 && args[0] == "info") return info(args[1]);
+        if ((args.size() == 3 || args.size() == 4) && args[0] == "train")
+            return train(args[1], args[2], args.size() == 4 ? std::stol(args[3]) : 10);
+        if (args.size() >= 3 && args.size() <= 5 && args[0] == "book")
+            return book(args[1], args[2], args.size() >= 4 ? std::stoi(args[3]) : 10,
+                        args.size() == 5 ? std::stol(args[4]) : 2);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return usage();
+}
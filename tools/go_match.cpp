@@ -0,0 +1,178 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <mutex>
+#include <optional>
+#include "../go/go.h"
+#include "../go/game_db.h"
+
+// Plays bots against each other, many games at a time across the shared pool, and estimates how much stronger the
+// first is. Colours alternate between games. As in atari go, the first capture wins; a resignation loses, and two
+// passes in a row or running out of moves is a draw.
+//
+// Usage: go_match <player> <player> [-g games] [-o out.agd] [-b book.agob] [-t patterns.agpt] [-s seed] [-p]
+//   player    a level, 1 to 6 for JOKE to DEMON, or custom settings in the order of GTP's set_bot_level 0:
+//             mcts_visits,ladder_depth,anti_ladder_depth,anti_ladder_nearest,minimax_depth,minimax_ladder,
+//             capture_prob,can_resign[,solver_empty_points[,minimax_shapes]]
+//   -g games  how many games to play (100)
+//   -o file   also save the games as a game database
+//   -b file   give the first player this opening book
+//   -t file   give the first player this pattern table, from go_db train
+//   -s seed   random seed (1)
+//   -p        pin the workers to cores, node by node, and make the bots NUMA aware
+
+static Bot::Settings parse_player(const std::string& s) {
+    if (s.find(',') == std::string::npos) {
+        int level = std::stoi(s);
+        if (level < 1 || level > 6) throw std::invalid_argument("unknown level " + s);
+        return Bot::level_settings((Bot::BotLevel) (level - 1));
+    }
+    std::vector<std::string> v;
+    std::istringstream in(s);
+    for (std::string item; std::getline(in, item, ',');) v.push_back(item);
+    if (v.size() < 8 || v.size() > 10) throw std::invalid_argument("expected 8 to 10 settings in " + s);
+    Bot::Settings res;
+    res.mcts_visits = std::stoi(v[0]);
+    res.ladder_depth = std::stoi(v[1]);
+    res.anti_ladder_depth = std::stoi(v[2]);
+    res.anti_ladder_nearest = v[3] == "1" || v[3] == "true";
+    res.minimax_depth = std::stoi(v[4]);
+    res.minimax_ladder = v[5] == "1" || v[5] == "true";
+    res.capture_prob = std::stod(v[6]);
+    res.can_resign = v[7] == "1" || v[7] == "true";
+    if (v.size() >= 9) res.solver_empty_points = std::stoi(v[8]);
+    if (v.size() == 10) res.minimax_shapes = v[9] == "1" || v[9] == "true";
+    return res;
+}
+
+static GameRecord play_game(const Bot::Settings& black, const Bot::Settings& white,
+                            const std::shared_ptr<const OpeningBook>& black_book,
+                            const std::shared_ptr<const OpeningBook>& white_book,
+                            const std::shared_ptr<const PatternTable>& black_patterns,
+                            const std::shared_ptr<const PatternTable>& white_patterns, bool numa_aware) {
+    Board board;
+    Bot bots[2] = {Bot(black, BLACK, board), Bot(white, WHITE, board)};
+    bots[BLACK].set_opening_book(black_book);
+    bots[WHITE].set_opening_book(white_book);
+    bots[BLACK].set_patterns(black_patterns);
+    bots[WHITE].set_patterns(white_patterns);
+    for (Bot& bot : bots) bot.set_numa_aware(numa_aware);
+    GameRecord game;
+    Color turn = BLACK;
+    int passes = 0;
+    for (int ply = 0; ply < 2 * size * size && passes < 2; ply++, turn = ~turn) {
+        Move m = bots[turn].get_move();
+        if (m.type() == Move::RESIGN) {
+            game.winner = ~turn;
+            break;
+        }
+        game.moves.push_back(m);
+        if (m.type() == Move::PASS) {
+            passes++;
+            continue;
+        }
+        passes = 0;
+        bool capture = board.is_capture(turn, m.pos());
+        if (!bots[turn].play(m)) {
+            game.moves.pop_back();
+            game.winner = ~turn;
+            break;
+        }
+        if (capture) {
+            game.winner = turn;
+            break;
+        }
+    }
+    return game;
+}
+
+// Elo difference that expects a share of `score` of the points
+static double elo(double score) {
+    score = std::clamp(score, 1e-6, 1 - 1e-6);
+    return -400 * std::log10(1 / score - 1);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> players;
+    int num_games = 100;
+    std::string out, book_path, patterns_path;
+    unsigned seed = 1;
+    bool pinned = false;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "-g") && i + 1 < argc) num_games = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-o") && i + 1 < argc) out = argv[++i];
+        else if (!std::strcmp(argv[i], "-b") && i + 1 < argc) book_path = argv[++i];
+        else if (!std::strcmp(argv[i], "-t") && i + 1 < argc) patterns_path = argv[++i];
+        else if (!std::strcmp(argv[i], "-s") && i + 1 < argc) seed = std::stoul(argv[++i]);
+        else if (!std::strcmp(argv[i], "-p")) pinned = true;
+        else players.emplace_back(argv[i]);
+    }
+    if (players.size() != 2 || num_games <= 0) {
+        std::cerr << "Usage: go_match <player> <player> [-g games] [-o out.agd] [-b book.agob] [-t patterns.agpt] "
+                     "[-s seed] [-p]" << std::endl;
+        return 1;
+    }
+    Bot::Settings settings[2];
+    std::shared_ptr<const OpeningBook> book;
+    std::shared_ptr<const PatternTable> patterns = PatternTable::uniform(), uniform = patterns;
+    try {
+        settings[0] = parse_player(players[0]), settings[1] = parse_player(players[1]);
+        if (!book_path.empty()) book = std::make_shared<const OpeningBook>(book_path);
+        if (!patterns_path.empty()) patterns = std::make_shared<const PatternTable>(PatternTable::load(patterns_path));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::srand(seed);
+
+    std::optional<GameDbWriter> writer;
+    if (!out.empty()) writer.emplace(out);
+
+    // Results from the first player's side: wins[colour it played]
+    std::mutex mutex;
+    long wins[2] = {}, losses[2] = {}, draws = 0, moves = 0, finished = 0;
+    auto start = std::chrono::steady_clock::now();
+    ThreadPool& pool = pinned ? ThreadPool::pinned() : ThreadPool::shared();
+    pool.parallel_for(0, num_games, [&](int i) {
+        Color first = i % 2 ? WHITE : BLACK;
+        GameRecord game = first == BLACK
+                ? play_game(settings[0], settings[1], book, nullptr, patterns, uniform, pinned)
+                : play_game(settings[1], settings[0], nullptr, book, uniform, patterns, pinned);
+
+        std::lock_guard lock(mutex);
+        if (!game.winner) draws++;
+        else if (*game.winner == first) wins[first]++;
+        else losses[first]++;
+        moves += (long) game.moves.size();
+        if (writer) writer->add(game.view());
+        if (++finished % 10 == 0 || finished == num_games)
+            std::cerr << "\r" << finished << "/" << num_games << " games" << std::flush;
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << std::endl;
+    if (writer) writer->close();
+
+    // Wilson interval around the first player's mean score, each game scoring 1, 1/2 or 0, which unlike the plain
+    // normal approximation stays wide when one side has won every game so far
+    double n = num_games, z = 1.96, score = (wins[BLACK] + wins[WHITE] + draws / 2.) / n;
+    double variance = ((wins[BLACK] + wins[WHITE]) * std::pow(1 - score, 2) + draws * std::pow(.5 - score, 2) +
+                       (losses[BLACK] + losses[WHITE]) * score * score) / n;
+    double centre = (score + z * z / (2 * n)) / (1 + z * z / n);
+    double margin = z / (1 + z * z / n) * std::sqrt(variance / n + z * z / (4 * n * n));
+    double low = std::max(centre - margin, 0.), high = std::min(centre + margin, 1.);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << players[0] << " vs " << players[1] << ": +" << wins[BLACK] + wins[WHITE] << " -"
+              << losses[BLACK] + losses[WHITE] << " =" << draws << "  (as black +" << wins[BLACK] << " -"
+              << losses[BLACK] << ", as white +" << wins[WHITE] << " -" << losses[WHITE] << ")\n"
+              << "score " << score * 100 << "% [" << low * 100 << "%, " << high * 100 << "%]  elo " << elo(score)
+              << " [" << elo(low) << ", " << elo(high) << "] (95%)\n"
+              << num_games / seconds << " games/s  " << (double) moves / seconds << " moves/s" << std::endl;
+    return 0;
+}